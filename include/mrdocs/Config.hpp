@@ -65,6 +65,18 @@ public:
         */
         bool multiPage = false;
 
+        /** `true` if unchanged pages of a multi-page output are skipped.
+
+            When enabled, the symbols each page depends on
+            are stored in the output directory, and a page
+            is only rendered again if one of them changed.
+
+            @code
+            skip-unchanged-pages: false
+            @endcode
+        */
+        bool skipUnchangedPages = false;
+
         //--------------------------------------------
 
         /** Full path to the working directory
@@ -22,6 +22,7 @@
 #include <ostream>
 #include <string>
 #include <string_view>
+#include <unordered_set>
 
 namespace clang {
 namespace mrdocs {
@@ -123,6 +124,39 @@ public:
         std::ostream& os,
         Corpus const& corpus) const = 0;
 
+    /** Build reference documentation for some symbols of the corpus.
+
+        This function is used to update the output
+        of an earlier build after the corpus changed.
+        Only the pages of the affected symbols are
+        emitted; the other pages are assumed to be
+        up to date. The pages of the earlier build
+        which no longer exist are deleted.
+
+        The default implementation emits the
+        full documentation by calling @ref build.
+
+        @return The error, if any occurred.
+
+        @param outputPath An existing directory or
+        a filename.
+
+        @param corpus The symbols to emit.
+
+        @param before The symbols of the earlier build.
+
+        @param affected The symbols whose pages
+        are out of date.
+    */
+    MRDOCS_DECL
+    virtual
+    Error
+    buildIncremental(
+        std::string_view outputPath,
+        Corpus const& corpus,
+        Corpus const& before,
+        std::unordered_set<SymbolID> const& affected) const;
+
     /** Build the reference as a single page to a file.
 
         @par Thread Safety
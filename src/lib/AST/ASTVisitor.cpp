@@ -26,12 +26,17 @@
 #include <clang/AST/TypeVisitor.h>
 #include <clang/Frontend/CompilerInstance.h>
 #include <clang/Index/USRGeneration.h>
+#include <clang/Lex/HeaderSearch.h>
 #include <clang/Lex/Lexer.h>
+#include <clang/Lex/MacroInfo.h>
+#include <clang/Lex/PPCallbacks.h>
+#include <clang/Lex/Preprocessor.h>
 #include <clang/Parse/ParseAST.h>
 #include <clang/Sema/Lookup.h>
 #include <clang/Sema/Sema.h>
 #include <clang/Sema/SemaConsumer.h>
 #include <clang/Sema/TemplateInstCallback.h>
+#include <llvm/ADT/DenseMap.h>
 #include <llvm/ADT/Hashing.h>
 #include <llvm/ADT/StringExtras.h>
 #include <llvm/ADT/SmallPtrSet.h>
@@ -144,14 +149,37 @@ public:
         std::string full_path;
         std::string_view short_path;
         FileKind kind;
+
+        // true if the declarations in this file
+        // are extracted by another translation unit
+        bool extracted_elsewhere = false;
     };
 
     std::unordered_map<
         const FileEntry*,
         FileInfo> files_;
 
+    // the FileInfo of each FileID, or nullptr
+    // for buffers which do not belong to a file
+    llvm::DenseMap<FileID, FileInfo*> file_ids_;
+
+    // the normalized source root and include search
+    // directories, used to build the FileInfo for a file
+    std::string source_root_;
+    std::vector<std::pair<std::string, FileKind>> search_dirs_;
+
     llvm::SmallString<128> usr_;
 
+    // the symbol ID of each declaration, keyed by its
+    // canonical declaration. declarations for which no
+    // USR can be generated map to SymbolID::invalid
+    llvm::DenseMap<const Decl*, SymbolID> symbol_ids_;
+
+    // the number of symbol IDs requested,
+    // and the number of USRs generated for them
+    std::size_t symbol_id_requests_ = 0;
+    std::size_t usr_generations_ = 0;
+
     SymbolFilter symbolFilter_;
 
     enum class ExtractMode
@@ -224,39 +252,13 @@ public:
         MRDOCS_ASSERT(context_.getTraversalScope() ==
             std::vector<Decl*>{context_.getTranslationUnitDecl()});
 
-        using namespace llvm::sys;
         Preprocessor& PP = sema_.getPreprocessor();
         HeaderSearch& HS = PP.getHeaderSearchInfo();
 
-        auto normalize_path = [&](
-            std::string_view old_path,
-            bool remove_filename)
-        {
-            llvm::SmallString<128> new_path(old_path);
-            if(remove_filename)
-                path::remove_filename(new_path);
-            // KRYSTIAN FIXME: use FileManager::makeAbsolutePath?
-            if(! path::is_absolute(new_path))
-            {
-                auto& cwd = source_.getFileManager().
-                    getFileSystemOpts().WorkingDir;
-                // we can't normalize a relative path
-                // without a base directory
-                MRDOCS_ASSERT(! cwd.empty());
-                fs::make_absolute(cwd, new_path);
-            }
-            // remove ./ and ../
-            path::remove_dots(new_path, true, path::Style::posix);
-            // convert to posix style
-            path::native(new_path, path::Style::posix);
-            return std::string(new_path);
-        };
-
-        std::string source_root = normalize_path(
+        source_root_ = normalizePath(
             config_->sourceRoot, true);
-        std::vector<std::pair<std::string, FileKind>> search_dirs;
 
-        search_dirs.reserve(HS.search_dir_size());
+        search_dirs_.reserve(HS.search_dir_size());
         // first, convert all the include search directories into POSIX style
         for(const DirectoryLookup& DL : HS.search_dir_range())
         {
@@ -265,34 +267,61 @@ public:
             if(! DL.isNormalDir() || ! DR)
                 continue;
             // store the normalized path
-            search_dirs.emplace_back(
-                normalize_path(DR->getName(), false),
+            search_dirs_.emplace_back(
+                normalizePath(DR->getName(), false),
                 DL.isSystemHeaderDirectory() ?
                     FileKind::System : FileKind::Other);
         }
 
-        auto build_file_info = [&](const FileEntry* file)
-        {
-            // "try" implies this may fail, so fallback to getName
-            // if an empty string is returned
-            std::string_view file_path =
-                file->tryGetRealPathName();
-            if(file_path.empty())
-                file_path = file->getName();
-            files_.emplace(file,
-                getFileInfo(search_dirs,
-                    normalize_path(file_path, false),
-                    source_root));
-        };
-
         // build the file info for the main file
-        build_file_info(
+        buildFileInfo(
             source_.getFileEntryForID(
                 source_.getMainFileID()));
 
         // build the file info for all included files
         for(const FileEntry* file : PP.getIncludedFiles())
-            build_file_info(file);
+            buildFileInfo(file);
+    }
+
+    std::string
+    normalizePath(
+        std::string_view old_path,
+        bool remove_filename)
+    {
+        using namespace llvm::sys;
+        llvm::SmallString<128> new_path(old_path);
+        if(remove_filename)
+            path::remove_filename(new_path);
+        // KRYSTIAN FIXME: use FileManager::makeAbsolutePath?
+        if(! path::is_absolute(new_path))
+        {
+            auto& cwd = source_.getFileManager().
+                getFileSystemOpts().WorkingDir;
+            // we can't normalize a relative path
+            // without a base directory
+            MRDOCS_ASSERT(! cwd.empty());
+            fs::make_absolute(cwd, new_path);
+        }
+        // remove ./ and ../
+        path::remove_dots(new_path, true, path::Style::posix);
+        // convert to posix style
+        path::native(new_path, path::Style::posix);
+        return std::string(new_path);
+    }
+
+    FileInfo&
+    buildFileInfo(const FileEntry* file)
+    {
+        // "try" implies this may fail, so fallback to getName
+        // if an empty string is returned
+        std::string_view file_path =
+            file->tryGetRealPathName();
+        if(file_path.empty())
+            file_path = file->getName();
+        return files_.emplace(file,
+            getFileInfo(search_dirs_,
+                normalizePath(file_path, false),
+                source_root_)).first->second;
     }
 
     FileInfo
@@ -368,6 +397,79 @@ public:
         return info_;
     }
 
+    /** Return true if the declarations of a header do not depend on where it is included.
+
+        Only headers with an include guard or `#pragma once`
+        which were entered once by this translation unit
+        have a fingerprint, and can be shared. Headers such
+        as X-macro or `.def` files are expanded each time
+        they are included, possibly with different macros.
+    */
+    bool
+    isSharedHeader(
+        const FileEntry* file,
+        const std::unordered_map<
+            const FileEntry*, std::uint64_t>& fingerprints) const
+    {
+        return fingerprints.contains(file) &&
+            sema_.getPreprocessor().getHeaderSearchInfo(
+                ).isFileMultipleIncludeGuarded(file);
+    }
+
+    /** Skip the headers already extracted by another translation unit.
+
+        Headers in the source root which were extracted
+        with the same preprocessor fingerprint are marked,
+        and their declarations will not be traversed.
+    */
+    void
+    skipExtractedHeaders(
+        HeaderRegistry& registry,
+        const std::unordered_map<
+            const FileEntry*, std::uint64_t>& fingerprints)
+    {
+        const FileEntry* main_file =
+            source_.getFileEntryForID(
+                source_.getMainFileID());
+        for(auto& [file, file_info] : files_)
+        {
+            // the main file is always extracted, and files
+            // outside the source root are only extracted
+            // as dependencies
+            if(file == main_file ||
+                file_info.kind != FileKind::Source ||
+                ! isSharedHeader(file, fingerprints))
+                continue;
+            file_info.extracted_elsewhere = registry.contains(
+                file_info.full_path, fingerprints.at(file));
+        }
+    }
+
+    /** Add the headers extracted by this translation unit to the registry.
+
+        This must only be called once the translation
+        unit completed without errors.
+    */
+    void
+    registerExtractedHeaders(
+        HeaderRegistry& registry,
+        const std::unordered_map<
+            const FileEntry*, std::uint64_t>& fingerprints)
+    {
+        const FileEntry* main_file =
+            source_.getFileEntryForID(
+                source_.getMainFileID());
+        for(auto& [file, file_info] : files_)
+        {
+            if(file == main_file ||
+                file_info.kind != FileKind::Source ||
+                file_info.extracted_elsewhere ||
+                ! isSharedHeader(file, fingerprints))
+                continue;
+            registry.insert(file_info.full_path, fingerprints.at(file));
+        }
+    }
+
     void build()
     {
         // traverse the translation unit, only extracting
@@ -388,6 +490,16 @@ public:
         buildDependencies(previous);
     }
 
+    /** Report how many symbol IDs were served from the cache.
+    */
+    void
+    reportStatistics(llvm::StringRef file) const
+    {
+        report::debug(
+            "Generated {} USRs for {} symbol ID requests in \"{}\"",
+            usr_generations_, symbol_id_requests_, file.str());
+    }
+
     void buildDependencies(
         std::unordered_set<Decl*>& previous)
     {
@@ -535,6 +647,13 @@ public:
         // prior to USR generator to ensure that declarations
         // with parameter types which decay to the same type
         // generate the same USR
+        adjustParameterTypes(D);
+        return index::generateUSRForDecl(D, usr_);
+    }
+
+    void
+    adjustParameterTypes(const Decl* D)
+    {
         if(const auto* FD = dyn_cast<FunctionDecl>(D))
         {
             // apply the type adjustments specified in [dcl.fct] p5
@@ -544,7 +663,6 @@ public:
             for(ParmVarDecl* P : FD->parameters())
                 P->setType(context_.getSignatureParameterType(P->getType()));
         }
-        return index::generateUSRForDecl(D, usr_);
     }
 
     // Function to hash a given USR value for storage.
@@ -566,11 +684,30 @@ public:
             id = SymbolID::global;
             return true;
         }
+        ++symbol_id_requests_;
+        // every redeclaration has the same USR. friend
+        // declarations are their own canonical declaration
+        auto [it, created] = symbol_ids_.try_emplace(
+            D->getCanonicalDecl(), SymbolID::invalid);
+        if(! created)
+        {
+            // the parameter types of this redeclaration
+            // may not have been adjusted yet
+            adjustParameterTypes(D);
+            if(! it->second)
+                return false;
+            id = it->second;
+            return true;
+        }
+        ++usr_generations_;
         usr_.clear();
         if(generateUSR(D))
             return false;
         id = SymbolID(llvm::SHA1::hash(
             arrayRefFromStringRef(usr_)).data());
+        // generateUSR does not insert into the
+        // map, so the iterator is still valid
+        it->second = id;
         return true;
     }
 
@@ -650,26 +787,33 @@ public:
     // type named "SourceLocation"...
     FileInfo* getFileInfo(clang::SourceLocation loc)
     {
-        // KRYSTIAN FIXME: we really should not be
-        // calling getPresumedLoc this often,
-        // it's quite expensive
-        auto presumed = source_.getPresumedLoc(loc, false);
-        if(presumed.isInvalid())
+        if(loc.isInvalid())
             return nullptr;
-        const FileEntry* file =
-            source_.getFileEntryForID(
-                presumed.getFileID());
+        // #line directives are ignored, so the file is
+        // the one containing the expansion location
+        return getFileInfo(
+            source_.getDecomposedExpansionLoc(loc).first);
+    }
+
+    FileInfo* getFileInfo(FileID id)
+    {
+        if(id.isInvalid())
+            return nullptr;
+        auto [it, created] = file_ids_.try_emplace(id, nullptr);
+        if(! created)
+            return it->second;
+        const FileEntry* file = source_.getFileEntryForID(id);
         // KRYSTIAN NOTE: i have no idea under what
         // circumstances the file entry would be null
         if(! file)
             return nullptr;
-        // KRYSTIAN NOTE: i have no idea under what
-        // circumstances the file would not be in either
-        // the main file, or an included file
-        auto it = files_.find(file);
-        if(it == files_.end())
-            return nullptr;
-        return &it->second;
+        // files which are not the main file or an included
+        // file, e.g. headers whose declarations were loaded
+        // from a precompiled preamble
+        auto file_it = files_.find(file);
+        it->second = file_it != files_.end() ?
+            &file_it->second : &buildFileInfo(file);
+        return it->second;
     }
 
     void
@@ -679,10 +823,13 @@ public:
         bool definition,
         bool documented)
     {
-        unsigned line = source_.getPresumedLoc(
-            loc, false).getLine();
-        FileInfo* file = getFileInfo(loc);
+        // use the line table of the file directly rather
+        // than getPresumedLoc, which would decompose the
+        // location again to find the file
+        auto [id, offset] = source_.getDecomposedExpansionLoc(loc);
+        FileInfo* file = getFileInfo(id);
         MRDOCS_ASSERT(file);
+        unsigned line = source_.getLineNumber(id, offset);
         if(definition)
         {
             if(I.DefLoc)
@@ -2388,8 +2535,21 @@ void
 ASTVisitor::
 traverseContext(DeclContext* DC)
 {
+    // declarations at namespace scope which appear in a header
+    // already extracted by another translation unit are skipped
+    bool const check_file =
+        DC->isFileContext() &&
+        currentMode() == ExtractMode::Normal;
     for(auto* D : DC->decls())
+    {
+        if(check_file)
+        {
+            if(FileInfo* file = getFileInfo(D->getLocation());
+                file && file->extracted_elsewhere)
+                continue;
+        }
         traverseDecl(D);
+    }
 }
 
 //------------------------------------------------
@@ -3389,6 +3549,95 @@ class ASTInstantiationCallbacks
 #endif
 
 
+//------------------------------------------------
+//
+// HeaderFingerprinter
+//
+//------------------------------------------------
+
+/** Computes a fingerprint of the preprocessor state for each header.
+
+    The fingerprint of a header combines the predefined
+    macros with every macro defined or undefined before
+    the header was entered, in any file. Two translation
+    units which define the same macros in a different
+    order produce different fingerprints, which only
+    costs a redundant extraction.
+
+    A header which is entered more than once has no
+    fingerprint, since each entry can expand to
+    different declarations.
+*/
+class HeaderFingerprinter
+    : public PPCallbacks
+{
+    const SourceManager& source_;
+    const LangOptions& lang_;
+    llvm::hash_code state_;
+    std::unordered_map<
+        const FileEntry*, std::uint64_t>& fingerprints_;
+    std::unordered_set<const FileEntry*> reentered_;
+
+public:
+    HeaderFingerprinter(
+        Preprocessor& PP,
+        std::unordered_map<
+            const FileEntry*, std::uint64_t>& fingerprints)
+        : source_(PP.getSourceManager())
+        , lang_(PP.getLangOpts())
+        , state_(llvm::hash_value(PP.getPredefines()))
+        , fingerprints_(fingerprints)
+    {
+    }
+
+    void
+    FileChanged(
+        clang::SourceLocation Loc,
+        FileChangeReason Reason,
+        SrcMgr::CharacteristicKind,
+        FileID) override
+    {
+        if(Reason != FileChangeReason::EnterFile)
+            return;
+        const FileEntry* file = source_.getFileEntryForID(
+            source_.getFileID(Loc));
+        if(! file)
+            return;
+        if(reentered_.contains(file))
+            return;
+        auto [it, inserted] = fingerprints_.try_emplace(
+            file, static_cast<std::size_t>(state_));
+        if(! inserted)
+        {
+            fingerprints_.erase(it);
+            reentered_.insert(file);
+        }
+    }
+
+    void
+    MacroDefined(
+        const Token& MacroNameTok,
+        const MacroDirective* MD) override
+    {
+        const MacroInfo* MI = MD->getMacroInfo();
+        state_ = llvm::hash_combine(state_,
+            MacroNameTok.getIdentifierInfo()->getName(),
+            Lexer::getSourceText(CharSourceRange::getTokenRange(
+                MI->getDefinitionLoc(), MI->getDefinitionEndLoc()),
+                source_, lang_));
+    }
+
+    void
+    MacroUndefined(
+        const Token& MacroNameTok,
+        const MacroDefinition&,
+        const MacroDirective*) override
+    {
+        state_ = llvm::hash_combine(state_, "#undef",
+            MacroNameTok.getIdentifierInfo()->getName());
+    }
+};
+
 //------------------------------------------------
 //
 // ASTVisitorConsumer
@@ -3401,6 +3650,10 @@ class ASTVisitorConsumer
     const ConfigImpl& config_;
     ExecutionContext& ex_;
     CompilerInstance& compiler_;
+    const std::unordered_map<
+        const FileEntry*, std::uint64_t>& fingerprints_;
+    ExtractionCache::Entry* record_;
+    bool unity_;
 
     Sema* sema_ = nullptr;
 
@@ -3443,7 +3696,7 @@ class ASTVisitorConsumer
             return;
 
         // skip the translation unit if configured to do so
-        if(! config_.shouldVisitTU(
+        if(! unity_ && ! config_.shouldVisitTU(
             convert_to_slash(*file_name)))
             return;
 
@@ -3454,14 +3707,57 @@ class ASTVisitorConsumer
             Context,
             *sema_);
 
+        // skip headers already extracted by another
+        // translation unit. cached results must not depend
+        // on other translation units, so this is disabled
+        // when the results are recorded
+        bool const extract_once =
+            config_->extractHeadersOnce && ! record_;
+        if(extract_once)
+            visitor.skipExtractedHeaders(ex_.headers(), fingerprints_);
+
         // traverse the translation unit
         visitor.build();
+        visitor.reportStatistics(*file_name);
+
+        // the results of a unity batch are held until the
+        // batch is known to have succeeded. a batch which
+        // fails is extracted again file by file, so its
+        // partial results are dropped instead of merged
+        bool const failed =
+            compiler_.getDiagnostics().hasErrorOccurred();
+        if(unity_ && failed)
+            return;
+
+        // the headers of a translation unit with errors
+        // may be incomplete, so they are left to other ones.
+        // the headers of a unity batch are never registered,
+        // since their fingerprints depend on the other files
+        // of the batch
+        if(extract_once && ! failed && ! unity_)
+            visitor.registerExtractedHeaders(
+                ex_.headers(), fingerprints_);
 
         // VFALCO If we returned from the function early
         // then this line won't execute, which means we
         // will miss error and warnings emitted before
         // the return.
-        ex_.report(std::move(visitor.results()), std::move(diags));
+        if(! record_)
+        {
+            ex_.report(std::move(visitor.results()), std::move(diags));
+            return;
+        }
+
+        // record the bitcode so it can be stored in the cache
+        std::vector<SerializedInfo> bitcode;
+        bitcode.reserve(visitor.results().size());
+        for(auto const& I : visitor.results())
+            bitcode.push_back({I->id, writeBitcode(*I)});
+        record_->bitcode.insert(
+            record_->bitcode.end(),
+            bitcode.begin(), bitcode.end());
+        record_->diagnostics = diags;
+        ex_.report(std::move(bitcode), std::move(diags));
     }
 
     /** Skip function bodies
@@ -3523,10 +3819,17 @@ public:
     ASTVisitorConsumer(
         const ConfigImpl& config,
         ExecutionContext& ex,
-        CompilerInstance& compiler) noexcept
+        CompilerInstance& compiler,
+        const std::unordered_map<
+            const FileEntry*, std::uint64_t>& fingerprints,
+        ExtractionCache::Entry* record,
+        bool unity) noexcept
         : config_(config)
         , ex_(ex)
         , compiler_(compiler)
+        , fingerprints_(fingerprints)
+        , record_(record)
+        , unity_(unity)
     {
     }
 };
@@ -3542,9 +3845,13 @@ struct ASTAction
 {
     ASTAction(
         ExecutionContext& ex,
-        ConfigImpl const& config) noexcept
+        ConfigImpl const& config,
+        ExtractionCache::Entry* record,
+        bool unity) noexcept
         : ex_(ex)
         , config_(config)
+        , record_(record)
+        , unity_(unity)
     {
     }
 
@@ -3569,18 +3876,42 @@ struct ASTAction
             true); // SkipFunctionBodies
     }
 
+    bool
+    BeginSourceFileAction(
+        CompilerInstance& CI) override
+    {
+        Preprocessor& PP = CI.getPreprocessor();
+        if(record_)
+        {
+            PP.addPPCallbacks(std::make_unique<IncludeHasher>(
+                CI.getSourceManager(), record_->dependencies));
+        }
+        else if(config_->extractHeadersOnce)
+        {
+            PP.addPPCallbacks(std::make_unique<
+                HeaderFingerprinter>(PP, fingerprints_));
+        }
+        return ASTFrontendAction::BeginSourceFileAction(CI);
+    }
+
     std::unique_ptr<clang::ASTConsumer>
     CreateASTConsumer(
         clang::CompilerInstance& Compiler,
         llvm::StringRef InFile) override
     {
         return std::make_unique<ASTVisitorConsumer>(
-            config_, ex_, Compiler);
+            config_, ex_, Compiler, fingerprints_, record_, unity_);
     }
 
 private:
     ExecutionContext& ex_;
     ConfigImpl const& config_;
+    ExtractionCache::Entry* record_;
+    bool unity_;
+
+    // preprocessor fingerprint of each included file
+    std::unordered_map<
+        const FileEntry*, std::uint64_t> fingerprints_;
 };
 
 //------------------------------------------------
@@ -3590,21 +3921,28 @@ struct ASTActionFactory :
 {
     ASTActionFactory(
         ExecutionContext& ex,
-        ConfigImpl const& config) noexcept
+        ConfigImpl const& config,
+        ExtractionCache::Entry* record,
+        bool unity) noexcept
         : ex_(ex)
         , config_(config)
+        , record_(record)
+        , unity_(unity)
     {
     }
 
     std::unique_ptr<FrontendAction>
     create() override
     {
-        return std::make_unique<ASTAction>(ex_, config_);
+        return std::make_unique<ASTAction>(
+            ex_, config_, record_, unity_);
     }
 
 private:
     ExecutionContext& ex_;
     ConfigImpl const& config_;
+    ExtractionCache::Entry* record_;
+    bool unity_;
 };
 
 } // (anon)
@@ -3614,9 +3952,12 @@ private:
 std::unique_ptr<tooling::FrontendActionFactory>
 makeFrontendActionFactory(
     ExecutionContext& ex,
-    ConfigImpl const& config)
+    ConfigImpl const& config,
+    ExtractionCache::Entry* record,
+    bool unity)
 {
-    return std::make_unique<ASTActionFactory>(ex, config);
+    return std::make_unique<ASTActionFactory>(
+        ex, config, record, unity);
 }
 
 } // mrdocs
@@ -15,6 +15,7 @@
 
 #include "lib/Lib/ConfigImpl.hpp"
 #include "lib/Lib/ExecutionContext.hpp"
+#include "lib/Lib/ExtractionCache.hpp"
 #include <mrdocs/Platform.hpp>
 #include <clang/Tooling/Tooling.h>
 
@@ -22,11 +23,27 @@ namespace clang {
 namespace mrdocs {
 
 /** Return a factory used to create our visitor.
+
+    @param ex The execution context which receives
+    the results of each translation unit.
+
+    @param config The configuration.
+
+    @param record If not null, the files read by
+    each translation unit and the bitcode for its
+    symbols are also recorded here, to be stored
+    in the extraction cache.
+
+    @param unity `true` if the main file of each
+    translation unit is a unity batch, whose
+    files were already filtered by `input.include`.
 */
 std::unique_ptr<tooling::FrontendActionFactory>
 makeFrontendActionFactory(
     ExecutionContext& ex,
-    ConfigImpl const& config);
+    ConfigImpl const& config,
+    ExtractionCache::Entry* record = nullptr,
+    bool unity = false);
 
 } // mrdocs
 } // clang
@@ -23,11 +23,32 @@
 namespace clang {
 namespace mrdocs {
 
+/** The serialized bitcode for a metadata node.
+*/
+struct SerializedInfo
+{
+    /** The ID of the serialized symbol.
+    */
+    SymbolID id;
+
+    /** The bitcode for the symbol.
+    */
+    llvm::SmallString<0> bitcode;
+};
+
 /** Return the serialized bitcode for a metadata node.
 */
 llvm::SmallString<0>
 writeBitcode(Info const& I);
 
+/** Return the serialized bitcode for many metadata nodes.
+
+    The nodes are written to one stream with a single
+    header, which is read back by @ref readBitcode.
+*/
+llvm::SmallString<0>
+writeBitcode(std::vector<Info const*> const& infos);
+
 /** Return an array of Info read from a bitstream.
 */
 mrdocs::Expected<std::vector<std::unique_ptr<Info>>>
@@ -1259,5 +1259,18 @@ writeBitcode(const Info& info)
     return buffer;
 }
 
+/** Write many Infos to the buffer as one bitcode stream.
+*/
+llvm::SmallString<0>
+writeBitcode(std::vector<Info const*> const& infos)
+{
+    llvm::SmallString<0> buffer;
+    llvm::BitstreamWriter stream(buffer);
+    BitcodeWriter writer(stream);
+    for(Info const* info : infos)
+        writer.dispatchInfoForWrite(*info);
+    return buffer;
+}
+
 } // mrdocs
 } // clang
@@ -10,6 +10,7 @@
 //
 
 #include "AdocCorpus.hpp"
+#include "lib/Metadata/DomDependencies.hpp"
 #include "lib/Support/Radix.hpp"
 #include <mrdocs/Support/RangeFor.hpp>
 #include <mrdocs/Support/String.hpp>
@@ -507,6 +508,15 @@ std::string
 AdocCorpus::
 getXref(Info const& I) const
 {
+    // the safe name of a symbol is qualified by its
+    // enclosing scopes, and each name depends on the
+    // other members of the scope which declares it
+    if(auto* deps = DomDependencies::current())
+    {
+        deps->insert(I.id);
+        for(SymbolID const& id : I.Namespace)
+            deps->insert(id);
+    }
     bool multipage = getCorpus().config->multiPage;
     // use '/' as the seperator for multi-page, and '-' for single-page
     std::string xref = names_.getQualified(
@@ -521,6 +531,15 @@ std::string
 AdocCorpus::
 getXref(OverloadSet const& os) const
 {
+    if(auto* deps = DomDependencies::current())
+    {
+        deps->insert(os.Parent);
+        if(Info const* parent = getCorpus().find(os.Parent))
+        {
+            for(SymbolID const& id : parent->Namespace)
+                deps->insert(id);
+        }
+    }
     bool multipage = getCorpus().config->multiPage;
     // use '/' as the seperator for multi-page, and '-' for single-page
     std::string xref = names_.getQualified(
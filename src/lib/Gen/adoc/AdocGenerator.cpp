@@ -18,7 +18,11 @@
 #include <mrdocs/Metadata/DomMetadata.hpp>
 #include <mrdocs/Support/Error.hpp>
 #include <mrdocs/Support/Path.hpp>
+#include <llvm/Support/FileSystem.h>
 #include <optional>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
 namespace clang {
@@ -52,15 +56,66 @@ createExecutors(
 //
 //------------------------------------------------
 
+/** Return the path of every page of a multi-page build.
+
+    Each path is mapped to the symbol of the page,
+    or to the first function of an overload set.
+*/
+class PageLister
+{
+    Corpus const& corpus_;
+    SafeNames names_;
+    std::unordered_map<std::string, SymbolID>& pages_;
+
+public:
+    PageLister(
+        Corpus const& corpus,
+        bool safeNames,
+        std::unordered_map<std::string, SymbolID>& pages)
+        : corpus_(corpus)
+        , names_(corpus, safeNames)
+        , pages_(pages)
+    {
+    }
+
+    template<class T>
+    void operator()(T const& I)
+    {
+        pages_.emplace(names_.getQualified(I.id, '/') + ".adoc", I.id);
+        if constexpr(
+                T::isNamespace() ||
+                T::isRecord() ||
+                T::isEnum())
+            corpus_.traverseOverloads(I, *this);
+    }
+
+    void operator()(OverloadSet const& OS)
+    {
+        pages_.emplace(names_.getQualified(OS, '/') + ".adoc",
+            OS.Members.front());
+        corpus_.traverse(OS, *this);
+    }
+};
+
+static
+std::unordered_map<std::string, SymbolID>
+listPages(
+    Corpus const& corpus,
+    bool safeNames)
+{
+    std::unordered_map<std::string, SymbolID> pages;
+    PageLister lister(corpus, safeNames, pages);
+    lister(corpus.globalNamespace());
+    return pages;
+}
+
+static
 Error
-AdocGenerator::
-build(
+buildMultiPage(
     std::string_view outputPath,
-    Corpus const& corpus) const
+    Corpus const& corpus,
+    std::unordered_set<SymbolID> const* affected)
 {
-    if(! corpus.config->multiPage)
-        return Generator::build(outputPath, corpus);
-
     auto options = loadOptions(corpus);
     if(! options)
         return options.error();
@@ -70,15 +125,44 @@ build(
     if(! ex)
         return ex.error();
 
-    MultiPageVisitor visitor(*ex, outputPath, corpus);
+    // the dependencies of each page are only
+    // recorded if unchanged pages are skipped
+    std::optional<PageManifest> manifest;
+    if(corpus.config->skipUnchangedPages)
+    {
+        auto hashes = hashSymbols(corpus);
+        if(! hashes)
+            return hashes.error();
+        manifest.emplace(outputPath, files::appendPath(
+            corpus.config->addonsDir, "generator", "asciidoc"),
+            corpus, *std::move(hashes));
+    }
+    MultiPageVisitor visitor(*ex, outputPath, corpus, affected,
+        manifest ? &*manifest : nullptr);
     visitor(corpus.globalNamespace());
 
     auto errors = ex->wait();
     if(! errors.empty())
         return Error(errors);
+    if(manifest)
+    {
+        manifest->save();
+        manifest->reportEnd(report::Level::info);
+    }
     return Error::success();
 }
 
+Error
+AdocGenerator::
+build(
+    std::string_view outputPath,
+    Corpus const& corpus) const
+{
+    if(! corpus.config->multiPage)
+        return Generator::build(outputPath, corpus);
+    return buildMultiPage(outputPath, corpus, nullptr);
+}
+
 Error
 AdocGenerator::
 buildOne(
@@ -125,6 +209,49 @@ buildOne(
     return Error::success();
 }
 
+Error
+AdocGenerator::
+buildIncremental(
+    std::string_view outputPath,
+    Corpus const& corpus,
+    Corpus const& before,
+    std::unordered_set<SymbolID> const& affected) const
+{
+    // the single page always lists every symbol
+    if(! corpus.config->multiPage)
+        return Generator::build(outputPath, corpus);
+
+    auto options = loadOptions(corpus);
+    if(! options)
+        return options.error();
+
+    // the path of a page depends on the names of the
+    // siblings of the symbol and of its parents, so
+    // the pages are compared by path. the pages at new
+    // paths, or at paths which now belong to another
+    // symbol, are written. the pages at paths which
+    // no longer exist are deleted
+    auto const old_pages = listPages(before, options->safe_names);
+    auto const new_pages = listPages(corpus, options->safe_names);
+    std::unordered_set<SymbolID> pages = affected;
+    for(auto const& [path, id] : new_pages)
+    {
+        auto it = old_pages.find(path);
+        if(it == old_pages.end() || it->second != id)
+            pages.insert(id);
+    }
+    for(auto const& [path, id] : old_pages)
+    {
+        if(new_pages.contains(path))
+            continue;
+        std::string fileName = files::appendPath(outputPath, path);
+        if(auto ec = llvm::sys::fs::remove(fileName))
+            return formatError("Failed to remove \"{}\": {}",
+                fileName, ec);
+    }
+    return buildMultiPage(outputPath, corpus, &pages);
+}
+
 } // adoc
 
 //------------------------------------------------
@@ -50,6 +50,13 @@ public:
     buildOne(
         std::ostream& os,
         Corpus const& corpus) const override;
+
+    Error
+    buildIncremental(
+        std::string_view outputPath,
+        Corpus const& corpus,
+        Corpus const& before,
+        std::unordered_set<SymbolID> const& affected) const override;
 };
 
 } // adoc
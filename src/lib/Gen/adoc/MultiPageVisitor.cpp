@@ -9,8 +9,11 @@
 //
 
 #include "MultiPageVisitor.hpp"
+#include "lib/Metadata/DomDependencies.hpp"
 #include <mrdocs/Support/Path.hpp>
+#include <algorithm>
 #include <fstream>
+#include <optional>
 
 namespace clang {
 namespace mrdocs {
@@ -43,6 +46,35 @@ writePage(
     }
 }
 
+void
+MultiPageVisitor::
+renderPage(
+    Builder& builder,
+    auto const& I,
+    std::string_view fileName)
+{
+    if(manifest_ && manifest_->upToDate(fileName))
+        return;
+
+    // record the symbols the page depends on
+    std::optional<DomDependencies> deps;
+    if(manifest_)
+        deps.emplace();
+    if(const auto r = builder(I))
+        writePage(*r, fileName);
+    else
+        r.error().Throw();
+    if(manifest_)
+        manifest_->record(fileName, deps->ids());
+}
+
+bool
+MultiPageVisitor::
+isAffected(SymbolID const& id) const noexcept
+{
+    return ! affected_ || affected_->contains(id);
+}
+
 template<class T>
 void
 MultiPageVisitor::
@@ -50,10 +82,10 @@ operator()(T const& I)
 {
     ex_.async([this, &I](Builder& builder)
     {
-        if(const auto r = builder(I))
-            writePage(*r, builder.domCorpus.getXref(I));
-        else
-            r.error().Throw();
+        // unaffected pages are skipped, but
+        // their members may still be affected
+        if(isAffected(I.id))
+            renderPage(builder, I, builder.domCorpus.getXref(I));
         if constexpr(
                 T::isNamespace() ||
                 T::isRecord() ||
@@ -71,10 +103,13 @@ operator()(OverloadSet const& OS)
 {
     ex_.async([this, OS](Builder& builder)
     {
-        if(const auto r = builder(OS))
-            writePage(*r, builder.domCorpus.getXref(OS));
-        else
-            r.error().Throw();
+        // the page of an overload set lists every overload
+        if(std::ranges::any_of(OS.Members,
+            [this](SymbolID const& id)
+            {
+                return isAffected(id);
+            }))
+            renderPage(builder, OS, builder.domCorpus.getXref(OS));
         corpus_.traverse(OS, *this);
     });
 }
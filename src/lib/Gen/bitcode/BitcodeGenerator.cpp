@@ -11,7 +11,7 @@
 
 #include "BitcodeGenerator.hpp"
 #include "lib/Support/Error.hpp"
-#include "lib/Support/SafeNames.hpp"
+#include "lib/Support/Radix.hpp"
 #include "lib/AST/Bitcode.hpp"
 #include <mrdocs/Support/ThreadPool.hpp>
 #include <mrdocs/Metadata.hpp>
@@ -26,7 +26,6 @@ class MultiFileBuilder
 {
     Corpus const& corpus_;
     std::string_view outputPath_;
-    SafeNames names_;
     TaskGroup taskGroup_;
 
 public:
@@ -35,7 +34,6 @@ public:
         Corpus const& corpus)
         : corpus_(corpus)
         , outputPath_(outputPath)
-        , names_(corpus_, true)
         , taskGroup_(corpus.config.threadPool())
     {
     }
@@ -43,8 +41,9 @@ public:
     Error
     build()
     {
-        corpus_.traverse(
-            corpus_.globalNamespace(), *this);
+        // the global namespace is written as well,
+        // so that the files can be loaded as a corpus
+        (*this)(corpus_.globalNamespace());
         auto errors = taskGroup_.wait();
         if(! errors.empty())
             return Error(errors);
@@ -61,7 +60,9 @@ public:
             [&]
             {
                 llvm::SmallString<512> filePath(outputPath_);
-                path::append(filePath, names_.getUnqualified(I.id));
+                // the unqualified names of symbols in
+                // different scopes can be the same
+                path::append(filePath, toBase16(I.id));
                 filePath.append(".bc");
                 std::error_code ec;
                 llvm::raw_fd_ostream os(filePath, ec, fs::CD_CreateAlways);
@@ -78,7 +79,8 @@ public:
         if constexpr(
             T::isRecord() ||
             T::isNamespace() ||
-            T::isEnum())
+            T::isEnum() ||
+            T::isSpecialization())
             corpus_.traverse(I, *this);
     }
 };
@@ -89,6 +91,7 @@ class SingleFileBuilder
 {
     Corpus const& corpus_;
     std::ostream& os_;
+    std::vector<Info const*> infos_;
 
 public:
     SingleFileBuilder(
@@ -102,7 +105,11 @@ public:
     Error
     build()
     {
-        corpus_.traverse(corpus_.globalNamespace(), *this);
+        // every symbol is written to one stream,
+        // which has a single header
+        (*this)(corpus_.globalNamespace());
+        auto bc = writeBitcode(infos_);
+        os_.write(bc.data(), bc.size());
         return Error::success();
     }
 
@@ -110,12 +117,12 @@ public:
     void
     operator()(T const& I)
     {
-        auto bc = writeBitcode(I);
-        os_.write(bc.data(), bc.size());
+        infos_.push_back(&I);
         if constexpr(
             T::isRecord() ||
             T::isNamespace() ||
-            T::isEnum())
+            T::isEnum() ||
+            T::isSpecialization())
             corpus_.traverse(I, *this);
     }
 };
@@ -14,10 +14,12 @@
 #include "Builder.hpp"
 #include "MultiPageVisitor.hpp"
 #include "SinglePageVisitor.hpp"
+#include "lib/Support/Radix.hpp"
 #include "lib/Support/SafeNames.hpp"
 #include <mrdocs/Metadata/DomMetadata.hpp>
 #include <mrdocs/Support/Error.hpp>
 #include <mrdocs/Support/Path.hpp>
+#include <llvm/Support/FileSystem.h>
 #include <optional>
 #include <vector>
 
@@ -53,28 +55,55 @@ createExecutors(
 //
 //------------------------------------------------
 
+static
 Error
-HTMLGenerator::
-build(
+buildMultiPage(
     std::string_view outputPath,
-    Corpus const& corpus) const
+    Corpus const& corpus,
+    std::unordered_set<SymbolID> const* affected)
 {
-    if(! corpus.config->multiPage)
-        return Generator::build(outputPath, corpus);
-
     HTMLCorpus domCorpus(corpus);
     auto ex = createExecutors(domCorpus);
     if(! ex)
         return ex.error();
 
-    MultiPageVisitor visitor(*ex, outputPath, corpus);
+    // the dependencies of each page are only
+    // recorded if unchanged pages are skipped
+    std::optional<PageManifest> manifest;
+    if(corpus.config->skipUnchangedPages)
+    {
+        auto hashes = hashSymbols(corpus);
+        if(! hashes)
+            return hashes.error();
+        manifest.emplace(outputPath, files::appendPath(
+            corpus.config->addonsDir, "generator", "html"),
+            corpus, *std::move(hashes));
+    }
+    MultiPageVisitor visitor(*ex, outputPath, corpus, affected,
+        manifest ? &*manifest : nullptr);
     visitor(corpus.globalNamespace());
     auto errors = ex->wait();
     if(! errors.empty())
         return Error(errors);
+    if(manifest)
+    {
+        manifest->save();
+        manifest->reportEnd(report::Level::info);
+    }
     return Error::success();
 }
 
+Error
+HTMLGenerator::
+build(
+    std::string_view outputPath,
+    Corpus const& corpus) const
+{
+    if(! corpus.config->multiPage)
+        return Generator::build(outputPath, corpus);
+    return buildMultiPage(outputPath, corpus, nullptr);
+}
+
 Error
 HTMLGenerator::
 buildOne(
@@ -117,6 +146,33 @@ buildOne(
     return Error::success();
 }
 
+Error
+HTMLGenerator::
+buildIncremental(
+    std::string_view outputPath,
+    Corpus const& corpus,
+    Corpus const& before,
+    std::unordered_set<SymbolID> const& affected) const
+{
+    // the single page always lists every symbol
+    if(! corpus.config->multiPage)
+        return Generator::build(outputPath, corpus);
+
+    // pages are named by symbol ID, so only
+    // the pages of removed symbols are stale
+    for(Info const& I : before)
+    {
+        if(corpus.exists(I.id))
+            continue;
+        std::string fileName = files::appendPath(
+            outputPath, toBase16(I.id) + ".html");
+        if(auto ec = llvm::sys::fs::remove(fileName))
+            return formatError("Failed to remove \"{}\": {}",
+                fileName, ec);
+    }
+    return buildMultiPage(outputPath, corpus, &affected);
+}
+
 } // html
 
 //------------------------------------------------
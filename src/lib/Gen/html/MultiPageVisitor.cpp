@@ -9,8 +9,10 @@
 //
 
 #include "MultiPageVisitor.hpp"
+#include "lib/Metadata/DomDependencies.hpp"
 #include <mrdocs/Support/Path.hpp>
 #include <fstream>
+#include <optional>
 
 namespace clang {
 namespace mrdocs {
@@ -21,7 +23,10 @@ void
 MultiPageVisitor::
 operator()(T const& I)
 {
-    renderPage(I);
+    // unaffected pages are skipped, but
+    // their members may still be affected
+    if(! affected_ || affected_->contains(I.id))
+        renderPage(I);
     if constexpr(
             T::isNamespace() ||
             T::isRecord() ||
@@ -37,10 +42,20 @@ renderPage(
     ex_.async(
         [this, &I](Builder& builder)
         {
+            std::string pageName = toBase16(I.id) + ".html";
+            if(manifest_ && manifest_->upToDate(pageName))
+                return;
+
+            // record the symbols the page depends on
+            std::optional<DomDependencies> deps;
+            if(manifest_)
+                deps.emplace();
             auto pageText = builder(I).value();
+            if(manifest_)
+                manifest_->record(pageName, deps->ids());
 
             std::string fileName = files::appendPath(
-                outputPath_, toBase16(I.id) + ".html");
+                outputPath_, pageName);
             std::ofstream os;
             try
             {
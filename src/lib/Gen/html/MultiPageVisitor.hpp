@@ -12,10 +12,12 @@
 #define MRDOCS_LIB_GEN_HTML_MULTIPAGEVISITOR_HPP
 
 #include "Builder.hpp"
+#include "lib/Lib/PageManifest.hpp"
 #include <mrdocs/Support/ExecutorGroup.hpp>
 #include <mutex>
 #include <ostream>
 #include <string>
+#include <unordered_set>
 #include <vector>
 
 namespace clang {
@@ -29,15 +31,30 @@ class MultiPageVisitor
     ExecutorGroup<Builder>& ex_;
     std::string_view outputPath_;
     Corpus const& corpus_;
+    std::unordered_set<SymbolID> const* affected_;
+    PageManifest* manifest_;
 
 public:
+    /** Constructor.
+
+        @param affected The symbols whose pages are
+        emitted, or `nullptr` to emit every page.
+
+        @param manifest The dependencies of the pages
+        written by the last run, or `nullptr` to emit
+        every page.
+    */
     MultiPageVisitor(
         ExecutorGroup<Builder>& ex,
         std::string_view outputPath,
-        Corpus const& corpus) noexcept
+        Corpus const& corpus,
+        std::unordered_set<SymbolID> const* affected = nullptr,
+        PageManifest* manifest = nullptr) noexcept
         : ex_(ex)
         , outputPath_(outputPath)
         , corpus_(corpus)
+        , affected_(affected)
+        , manifest_(manifest)
     {
     }
 
@@ -0,0 +1,93 @@
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+// Copyright (c) 2023 Vinnie Falco (vinnie.falco@gmail.com)
+//
+// Official repository: https://github.com/cppalliance/mrdocs
+//
+
+#include "CompileGroups.hpp"
+#include <llvm/ADT/StringMap.h>
+#include <llvm/Support/Path.h>
+
+namespace clang {
+namespace mrdocs {
+
+std::vector<std::string>
+getParsingArguments(
+    tooling::CompileCommand const& command)
+{
+    llvm::StringRef const file_name =
+        llvm::sys::path::filename(command.Filename);
+    std::vector<std::string> args;
+    args.reserve(command.CommandLine.size());
+    for(std::size_t i = 0; i < command.CommandLine.size(); ++i)
+    {
+        llvm::StringRef arg = command.CommandLine[i];
+        // the input file, possibly relative
+        // to the working directory
+        if(arg == command.Filename || (
+            ! arg.starts_with("-") &&
+            llvm::sys::path::filename(arg) == file_name))
+            continue;
+        // options with a separate value
+        if(arg == "-o" || arg == "-MF" ||
+            arg == "-MT" || arg == "-MQ")
+        {
+            ++i;
+            continue;
+        }
+        // options with a joined value, and flags
+        // which only affect the build outputs
+        if(arg.starts_with("-o") ||
+            arg.starts_with("-MF") ||
+            arg.starts_with("-MT") ||
+            arg.starts_with("-MQ") ||
+            arg.starts_with("/Fo") ||
+            arg == "-c" || arg == "-M" || arg == "-MM" ||
+            arg == "-MD" || arg == "-MMD" || arg == "-MP")
+            continue;
+        args.emplace_back(arg);
+    }
+    return args;
+}
+
+std::vector<CompileGroup>
+groupCompileCommands(
+    tooling::CompilationDatabase const& compilations,
+    std::vector<std::string> const& files)
+{
+    std::vector<CompileGroup> groups;
+    llvm::StringMap<std::size_t> index;
+    for(auto const& file : files)
+    {
+        auto commands = compilations.getCompileCommands(file);
+        if(commands.empty())
+            continue;
+        std::vector<std::string> args =
+            getParsingArguments(commands.front());
+
+        std::string key = commands.front().Directory;
+        for(auto const& arg : args)
+        {
+            key.push_back('\0');
+            key.append(arg);
+        }
+
+        auto [it, created] = index.try_emplace(key, groups.size());
+        if(created)
+        {
+            groups.push_back({
+                std::move(commands.front()),
+                std::move(args),
+                {}});
+        }
+        groups[it->second].files.push_back(file);
+    }
+    return groups;
+}
+
+} // mrdocs
+} // clang
@@ -0,0 +1,66 @@
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+// Copyright (c) 2023 Vinnie Falco (vinnie.falco@gmail.com)
+//
+// Official repository: https://github.com/cppalliance/mrdocs
+//
+
+#ifndef MRDOCS_LIB_COMPILEGROUPS_HPP
+#define MRDOCS_LIB_COMPILEGROUPS_HPP
+
+#include <mrdocs/Platform.hpp>
+#include <clang/Tooling/CompilationDatabase.h>
+#include <string>
+#include <vector>
+
+namespace clang {
+namespace mrdocs {
+
+/** A set of translation units compiled with equivalent flags.
+*/
+struct CompileGroup
+{
+    /** The compile command of the first file in the group.
+    */
+    tooling::CompileCommand command;
+
+    /** The arguments shared by every file in the group.
+
+        These are the arguments of the compile command
+        with the input file and output options removed.
+    */
+    std::vector<std::string> arguments;
+
+    /** The files in the group, in database order.
+    */
+    std::vector<std::string> files;
+};
+
+/** Return the arguments of a compile command which affect parsing.
+
+    The input file and the options naming
+    output or dependency files are removed.
+*/
+std::vector<std::string>
+getParsingArguments(
+    tooling::CompileCommand const& command);
+
+/** Group files by equivalent compile commands.
+
+    Two files are in the same group when their
+    first compile commands have the same working
+    directory and the same parsing arguments.
+    Files without a compile command are omitted.
+*/
+std::vector<CompileGroup>
+groupCompileCommands(
+    tooling::CompilationDatabase const& compilations,
+    std::vector<std::string> const& files);
+
+} // mrdocs
+} // clang
+
+#endif
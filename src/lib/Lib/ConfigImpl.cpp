@@ -89,6 +89,13 @@ struct llvm::yaml::MappingTraits<SettingsImpl>
     {
         io.mapOptional("defines",           cfg.defines);
         io.mapOptional("ignore-failures",   cfg.ignoreFailures);
+        io.mapOptional("extract-headers-once", cfg.extractHeadersOnce);
+        io.mapOptional("cache-dir",         cfg.cacheDir);
+        io.mapOptional("shared-preambles",  cfg.sharedPreambles);
+        io.mapOptional("minimal-tu-set",    cfg.minimalTUSet);
+        io.mapOptional("unity-batch-size",  cfg.unityBatchSize);
+        io.mapOptional("incremental-reduce", cfg.incrementalReduce);
+        io.mapOptional("memory-budget",     cfg.memoryBudget);
 
         // io.mapOptional("extract",           cfg.extract);
         io.mapOptional("referenced-declarations", cfg.referencedDeclarations);
@@ -99,6 +106,7 @@ struct llvm::yaml::MappingTraits<SettingsImpl>
 
         io.mapOptional("generate",          cfg.generate);
         io.mapOptional("multipage",         cfg.multiPage);
+        io.mapOptional("skip-unchanged-pages", cfg.skipUnchangedPages);
         io.mapOptional("source-root",       cfg.sourceRoot);
         io.mapOptional("base-url",               cfg.baseURL);
 
@@ -202,6 +210,13 @@ ConfigImpl(
     settings_.sourceRoot = files::makePosixStyle(files::makeDirsy(
         files::makeAbsolute(settings_.sourceRoot, settings_.workingDir)));
 
+    // Cache directory is resolved against the working directory
+    if(! settings_.cacheDir.empty())
+    {
+        settings_.cacheDir = files::makePosixStyle(
+            files::makeAbsolute(settings_.cacheDir, settings_.workingDir));
+    }
+
     // Base-URL has to be dirsy with forward slash style
     if (!settings_.baseURL.empty() && settings_.baseURL.back() != '/')
     {
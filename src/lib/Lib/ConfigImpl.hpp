@@ -83,6 +83,112 @@ public:
         */
         bool ignoreFailures = false;
 
+        /** `true` if headers should be extracted by only one translation unit.
+
+            When enabled, once a translation unit which
+            includes a header in the source root completes
+            without errors, the declarations in that header
+            are skipped by the translation units which start
+            afterwards and include it with the same macros
+            defined.
+
+            @code
+            extract-headers-once: false
+            @endcode
+        */
+        bool extractHeadersOnce = false;
+
+        /** The full path to the extraction cache directory.
+
+            When not empty, the extraction results of each
+            translation unit are stored in this directory,
+            and reused by subsequent runs as long as the
+            command line, the configuration, and every file
+            read by the translation unit are unchanged.
+            The durations of the translation units are
+            kept here as well, to schedule the slowest
+            ones first on the next run.
+
+            @code
+            cache-dir: .mrdocs-cache
+            @endcode
+        */
+        std::string cacheDir;
+
+        /** `true` if translation units should share precompiled preambles.
+
+            When enabled, translation units with equivalent
+            compile commands are grouped, and the system
+            includes at the start of every file in a group
+            are precompiled once and reused by the group.
+
+            @code
+            shared-preambles: false
+            @endcode
+        */
+        bool sharedPreambles = false;
+
+        /** `true` if only a covering subset of translation units is extracted.
+
+            When enabled, the dependencies of every translation
+            unit are scanned first, and only a minimal subset of
+            translation units which includes every file in the
+            source root is extracted.
+
+            This assumes that the declarations in a header do
+            not depend on the macros defined by the translation
+            unit which includes it. Otherwise, the translation
+            units which are dropped may declare different
+            symbols from the ones which are kept.
+
+            @code
+            minimal-tu-set: false
+            @endcode
+        */
+        bool minimalTUSet = false;
+
+        /** The maximum number of files in a unity batch.
+
+            When greater than one, files with equivalent
+            compile commands are combined into synthetic
+            translation units which include each of them,
+            so that the headers they share are only parsed
+            once per batch. Zero disables unity batches.
+
+            @code
+            unity-batch-size: 16
+            @endcode
+        */
+        unsigned unityBatchSize = 0;
+
+        /** `true` if symbols are merged while extraction is running.
+
+            When enabled, the bitcode reported by each
+            translation unit is decoded and merged into
+            the Info of its symbol right away, instead of
+            after every translation unit is extracted.
+            Only the merged Info is kept in memory.
+
+            @code
+            incremental-reduce: false
+            @endcode
+        */
+        bool incrementalReduce = false;
+
+        /** The size of the extracted bitcode kept in memory, in megabytes.
+
+            When the bitcode reported by the translation
+            units exceeds this size, it is written to a
+            temporary file and mapped back into memory
+            when the declarations are reduced. Zero keeps
+            all of it in memory.
+
+            @code
+            memory-budget: 4096
+            @endcode
+        */
+        unsigned memoryBudget = 0;
+
         /** The full path to the source root directory.
 
             The returned path will always be POSIX
@@ -0,0 +1,200 @@
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+// Copyright (c) 2023 Vinnie Falco (vinnie.falco@gmail.com)
+//
+// Official repository: https://github.com/cppalliance/mrdocs
+//
+
+#include "lib/Lib/CorpusDiff.hpp"
+#include "lib/AST/Bitcode.hpp"
+#include "lib/Lib/CorpusImpl.hpp"
+#include <mrdocs/Metadata.hpp>
+#include <mrdocs/Support/ThreadPool.hpp>
+#include <llvm/ADT/StringExtras.h>
+#include <llvm/Support/xxhash.h>
+#include <mutex>
+
+namespace clang {
+namespace mrdocs {
+
+namespace {
+
+/** Call a function with the ID of each reference in documentation.
+*/
+template<class F>
+void
+forEachReference(
+    doc::Node const& node,
+    F const& f)
+{
+    visit(node, [&]<typename NodeTy>(NodeTy const& N)
+    {
+        if constexpr(requires { N.children; })
+        {
+            for(auto const& child : N.children)
+                forEachReference(*child, f);
+        }
+
+        if constexpr(std::derived_from<NodeTy, doc::Reference>)
+        {
+            if(N.id)
+                f(N.id);
+        }
+    });
+}
+
+/** Return the members of a scope, or nullptr.
+*/
+std::vector<SymbolID> const*
+getMembers(Info const* I)
+{
+    if(! I)
+        return nullptr;
+    return visit(*I, []<class T>(T const& t) ->
+        std::vector<SymbolID> const*
+    {
+        if constexpr(std::derived_from<T, ScopeInfo>)
+            return &t.Members;
+        return nullptr;
+    });
+}
+
+/** Return a hash of the content of each symbol.
+*/
+Expected<SymbolHashes>
+computeHashes(Corpus const& corpus)
+{
+    std::vector<Info const*> infos;
+    for(Info const& I : corpus)
+        infos.push_back(&I);
+
+    std::vector<std::uint64_t> hashes(infos.size());
+    TaskGroup taskGroup(corpus.config.threadPool());
+    for(std::size_t i = 0; i < infos.size(); ++i)
+    {
+        taskGroup.async(
+            [&, i]
+            {
+                auto bitcode = writeBitcode(*infos[i]);
+                hashes[i] = llvm::xxh3_64bits(
+                    llvm::arrayRefFromStringRef(bitcode.str()));
+            });
+    }
+    auto errors = taskGroup.wait();
+    if(! errors.empty())
+        return Unexpected(Error(errors));
+
+    SymbolHashes result;
+    result.reserve(infos.size());
+    for(std::size_t i = 0; i < infos.size(); ++i)
+        result.emplace(infos[i]->id, hashes[i]);
+    return result;
+}
+
+} // (anon)
+
+Expected<std::shared_ptr<SymbolHashes const>>
+hashSymbols(Corpus const& corpus)
+{
+    auto const* impl = dynamic_cast<CorpusImpl const*>(&corpus);
+    std::unique_lock<std::mutex> lock;
+    if(impl)
+    {
+        lock = std::unique_lock<std::mutex>(impl->hashesMutex_);
+        if(impl->hashes_)
+            return impl->hashes_;
+    }
+    MRDOCS_TRY(auto hashes, computeHashes(corpus));
+    auto result = std::make_shared<SymbolHashes const>(
+        std::move(hashes));
+    if(impl)
+        impl->hashes_ = result;
+    return result;
+}
+
+Expected<CorpusDiff>
+diffCorpora(
+    Corpus const& before,
+    Corpus const& after)
+{
+    MRDOCS_TRY(auto const old_ptr, hashSymbols(before));
+    MRDOCS_TRY(auto const new_ptr, hashSymbols(after));
+    SymbolHashes const& old_hashes = *old_ptr;
+    SymbolHashes const& new_hashes = *new_ptr;
+
+    CorpusDiff diff;
+    for(auto const& [id, hash] : new_hashes)
+    {
+        auto it = old_hashes.find(id);
+        if(it == old_hashes.end())
+            diff.added.push_back(id);
+        else if(it->second != hash)
+            diff.changed.push_back(id);
+    }
+    for(auto const& [id, hash] : old_hashes)
+    {
+        if(! new_hashes.contains(id))
+            diff.removed.push_back(id);
+    }
+
+    // the set of symbols whose pages change,
+    // or which are listed on the pages of others
+    std::unordered_set<SymbolID> modified;
+    modified.insert(diff.added.begin(), diff.added.end());
+    modified.insert(diff.changed.begin(), diff.changed.end());
+    modified.insert(diff.removed.begin(), diff.removed.end());
+
+    auto const mark = [&](SymbolID const& id)
+    {
+        if(after.exists(id))
+            diff.affected.insert(id);
+    };
+    for(SymbolID const& id : modified)
+    {
+        mark(id);
+        // the pages of the enclosing scopes list their members
+        for(Info const* I : { before.find(id), after.find(id) })
+        {
+            if(! I)
+                continue;
+            for(SymbolID const& parent : I->Namespace)
+                mark(parent);
+        }
+
+        // the safe names of the members of a scope depend
+        // on each other, so adding or removing a member,
+        // such as an overload, can change the names and
+        // pages of its siblings
+        auto const* members = getMembers(after.find(id));
+        if(! members)
+            continue;
+        auto const* old_members = getMembers(before.find(id));
+        if(old_members && *old_members == *members)
+            continue;
+        for(SymbolID const& member : *members)
+            mark(member);
+    }
+
+    // symbols whose documentation refers to a modified symbol
+    for(Info const& I : after)
+    {
+        if(! I.javadoc)
+            continue;
+        for(auto const& block : I.javadoc->getBlocks())
+        {
+            forEachReference(*block,
+                [&](SymbolID const& id)
+                {
+                    if(modified.contains(id))
+                        diff.affected.insert(I.id);
+                });
+        }
+    }
+    return diff;
+}
+
+} // mrdocs
+} // clang
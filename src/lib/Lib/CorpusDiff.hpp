@@ -0,0 +1,96 @@
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+// Copyright (c) 2023 Vinnie Falco (vinnie.falco@gmail.com)
+//
+// Official repository: https://github.com/cppalliance/mrdocs
+//
+
+#ifndef MRDOCS_LIB_CORPUSDIFF_HPP
+#define MRDOCS_LIB_CORPUSDIFF_HPP
+
+#include <mrdocs/Platform.hpp>
+#include <mrdocs/Corpus.hpp>
+#include <mrdocs/Metadata/Symbols.hpp>
+#include <mrdocs/Support/Error.hpp>
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace clang {
+namespace mrdocs {
+
+/** The differences between two versions of a corpus.
+*/
+struct CorpusDiff
+{
+    /** The symbols which only exist in the new corpus.
+    */
+    std::vector<SymbolID> added;
+
+    /** The symbols which only exist in the old corpus.
+    */
+    std::vector<SymbolID> removed;
+
+    /** The symbols whose metadata or documentation changed.
+    */
+    std::vector<SymbolID> changed;
+
+    /** The symbols of the new corpus whose pages are out of date.
+
+        These are the added and changed symbols, the
+        scopes which enclose any added, removed or
+        changed symbol, every member of a scope whose
+        members changed, and the symbols whose
+        documentation refers to one of them.
+    */
+    std::unordered_set<SymbolID> affected;
+
+    /** Return true if the corpora have the same symbols.
+    */
+    bool
+    empty() const noexcept
+    {
+        return added.empty() &&
+            removed.empty() &&
+            changed.empty();
+    }
+};
+
+/** A hash of the content of each symbol of a corpus.
+*/
+using SymbolHashes = std::unordered_map<SymbolID, std::uint64_t>;
+
+/** Return a hash of the content of each symbol.
+
+    The hash covers every field of the symbol,
+    including its documentation, as they are
+    serialized to bitcode. The symbols are hashed
+    concurrently on the thread pool of the
+    configuration.
+
+    The hashes of a @ref CorpusImpl are computed
+    once and kept with the corpus, so that they are
+    shared by every caller.
+*/
+Expected<std::shared_ptr<SymbolHashes const>>
+hashSymbols(Corpus const& corpus);
+
+/** Return the differences between two versions of a corpus.
+
+    @param before The old corpus.
+    @param after The new corpus.
+*/
+Expected<CorpusDiff>
+diffCorpora(
+    Corpus const& before,
+    Corpus const& after);
+
+} // mrdocs
+} // clang
+
+#endif
@@ -12,13 +12,32 @@
 
 #include "CorpusImpl.hpp"
 #include "lib/AST/ASTVisitor.hpp"
+#include "lib/AST/Bitcode.hpp"
+#include "lib/AST/BitcodeIDs.hpp"
 #include "lib/Metadata/Finalize.hpp"
+#include "lib/Lib/CostHistory.hpp"
+#include "lib/Lib/CoveringSet.hpp"
+#include "lib/Lib/ExtractionCache.hpp"
 #include "lib/Lib/Lookup.hpp"
+#include "lib/Lib/SharedPreambles.hpp"
+#include "lib/Lib/UnityBatches.hpp"
+#include "lib/Support/BinaryIO.hpp"
+#include "lib/Support/CachingFileSystem.hpp"
 #include "lib/Support/Error.hpp"
+#include "lib/Support/Radix.hpp"
 #include <mrdocs/Metadata.hpp>
 #include <mrdocs/Support/Error.hpp>
+#include <mrdocs/Support/Path.hpp>
 #include <llvm/ADT/STLExtras.h>
+#include <llvm/ADT/StringExtras.h>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/MemoryBuffer.h>
+#include <llvm/Support/xxhash.h>
+#include <algorithm>
 #include <chrono>
+#include <mutex>
+#include <numeric>
+#include <optional>
 
 namespace clang {
 namespace mrdocs {
@@ -30,19 +49,13 @@ begin() const noexcept ->
 {
     if(info_.empty())
         return end();
-    // KRYSTIAN NOTE: this is far from ideal, but i'm not sure
-    // to what extent implementation detail should be hidden.
-    return iterator(this, info_.begin()->get(),
+    return iterator(this, *info_.begin(),
         [](const Corpus* corpus, const Info* val) ->
             const Info*
         {
             MRDOCS_ASSERT(val);
-            const CorpusImpl* impl =
-                static_cast<const CorpusImpl*>(corpus);
-            auto it = impl->info_.find(val->id);
-            if(++it == impl->info_.end())
-                return nullptr;
-            return it->get();
+            return static_cast<const CorpusImpl*>(
+                corpus)->info_.next(*val);
         });
 }
 
@@ -59,10 +72,7 @@ CorpusImpl::
 find(
     SymbolID const& id) noexcept
 {
-    auto it = info_.find(id);
-    if(it != info_.end())
-        return it->get();
-    return nullptr;
+    return info_.find(id);
 }
 
 Info const*
@@ -70,49 +80,109 @@ CorpusImpl::
 find(
     SymbolID const& id) const noexcept
 {
-    auto it = info_.find(id);
-    if(it != info_.end())
-        return it->get();
-    return nullptr;
+    return info_.find(id);
 }
 
 //------------------------------------------------
 
-mrdocs::Expected<std::unique_ptr<Corpus>>
-CorpusImpl::
-build(
-    report::Level reportLevel,
-    std::shared_ptr<ConfigImpl const> config,
-    tooling::CompilationDatabase const& compilations)
+namespace {
+
+using clock_type = std::chrono::steady_clock;
+
+std::string
+format_duration(clock_type::duration delta)
 {
-    using clock_type = std::chrono::steady_clock;
-    const auto format_duration =
-        [](clock_type::duration delta)
-    {
-        auto delta_ms = std::chrono::duration_cast<
-            std::chrono::milliseconds>(delta).count();
-        if(delta_ms < 1000)
-            return fmt::format("{} ms", delta_ms);
-        else
-            return fmt::format("{:.02f} s",
-                delta_ms / 1000.0);
+    auto delta_ms = std::chrono::duration_cast<
+        std::chrono::milliseconds>(delta).count();
+    if(delta_ms < 1000)
+        return fmt::format("{} ms", delta_ms);
+    else
+        return fmt::format("{:.02f} s",
+            delta_ms / 1000.0);
+}
+
+/** Return an error if a symbol refers to a missing parent or member.
+
+    The lookup tables and the finalizer require
+    every parent and member of a symbol to exist.
+*/
+Error
+checkReferences(InfoTable const& infos)
+{
+    auto const missing = [](
+        std::string_view what,
+        SymbolID const& id,
+        Info const& I)
+    {
+        return formatError("the {} {} of {} is missing",
+            what, toBase16(id), toBase16(I.id));
     };
-    auto start_time = clock_type::now();
+    for(Info const* I : infos)
+    {
+        for(SymbolID const& id : I->Namespace)
+        {
+            if(! infos.contains(id))
+                return missing("parent", id, *I);
+        }
+        Error err = visit(*I, [&]<class T>(T const& t) -> Error
+        {
+            if constexpr(std::derived_from<T, ScopeInfo>)
+            {
+                for(SymbolID const& id : t.Members)
+                {
+                    if(! infos.contains(id))
+                        return missing("member", id, *I);
+                }
+            }
+            return Error::success();
+        });
+        if(err)
+            return err;
+    }
+    return Error::success();
+}
 
-    auto corpus = std::make_unique<CorpusImpl>(config);
+// the snapshot file starts with the magic, the version
+// of the format, the bitcode version and the number of
+// symbols. it is followed by an index entry for each
+// symbol, sorted by SymbolID, and the bitcode of the
+// symbols. each index entry holds the SymbolID, and the
+// offset and size of its bitcode from the end of the index
+constexpr llvm::StringLiteral snapshotMagic = "MRDOCSSN";
+constexpr std::uint64_t snapshotVersion = 1;
+constexpr std::size_t snapshotEntrySize =
+    SymbolID().size() + 2 * sizeof(std::uint64_t);
 
-    // Traverse the AST for all translation units
-    // and emit serializd bitcode into tool results.
-    // This operation happens ona thread pool.
-    report::print(reportLevel, "Extracting declarations");
+/** Return the shard which extracts a file.
 
-    #define USE_BITCODE
+    Paths in the source root are hashed relative
+    to it, so that every machine assigns a file
+    to the same shard.
+*/
+std::size_t
+shardOf(
+    ConfigImpl const& config,
+    std::string_view file,
+    std::size_t shardCount)
+{
+    std::string path = files::makePosixStyle(file);
+    llvm::StringRef key(path);
+    key.consume_front(config->sourceRoot);
+    return llvm::xxh3_64bits(
+        llvm::arrayRefFromStringRef(key)) % shardCount;
+}
 
-    #ifdef USE_BITCODE
-        BitcodeExecutionContext context(*config);
-    #else
-        InfoExecutionContext context(*config);
-    #endif
+/** Extract the declarations of the translation units of a shard.
+*/
+mrdocs::Expected<void>
+extractDeclarations(
+    report::Level reportLevel,
+    std::shared_ptr<ConfigImpl const> const& config,
+    tooling::CompilationDatabase const& compilations,
+    ExecutionContext& context,
+    std::size_t shardIndex,
+    std::size_t shardCount)
+{
     std::unique_ptr<tooling::FrontendActionFactory> action =
         makeFrontendActionFactory(context, *config);
     MRDOCS_ASSERT(action);
@@ -124,29 +194,193 @@ build(
     if(files.empty())
         return Unexpected(formatError("Compilations database is empty"));
 
+    // Skip translation units which only include
+    // files already covered by other ones
+    if((*config)->minimalTUSet && files.size() > 1)
+        files = selectCoveringFiles(
+            *config, compilations, std::move(files), reportLevel);
+
+    // Keep the translation units of this shard. The covering
+    // set is selected first, so that the shards together
+    // extract the same translation units as a single run
+    if(shardCount > 1)
+    {
+        std::erase_if(files,
+            [&](std::string const& file)
+            {
+                return shardOf(*config, file, shardCount) != shardIndex;
+            });
+        report::format(reportLevel,
+            "Shard {} of {} has {} translation units",
+            shardIndex, shardCount, files.size());
+        if(files.empty())
+            return {};
+    }
+
+    // The results of unchanged translation
+    // units are loaded from the cache
+    std::optional<ExtractionCache> cache;
+    if(! (*config)->cacheDir.empty())
+        cache.emplace(*config, compilations);
+
+    // Build the preambles shared by files
+    // with equivalent compile commands
+    std::optional<SharedPreambles> preambles;
+    if((*config)->sharedPreambles)
+    {
+        preambles.emplace(*config, compilations);
+        preambles->build(files);
+    }
+
+    // Combine files with equivalent compile
+    // commands into unity batches
+    std::vector<UnityBatch> batches;
+    std::unique_ptr<tooling::FrontendActionFactory> unityAction;
+    if((*config)->unityBatchSize > 1)
+    {
+        // the main file of a batch is never in input.include,
+        // so the files are filtered before they are combined
+        std::erase_if(files,
+            [&](std::string const& file)
+            {
+                return ! config->shouldVisitTU(
+                    files::makePosixStyle(file));
+            });
+        batches = makeUnityBatches(
+            compilations, files, (*config)->unityBatchSize);
+        unityAction = makeFrontendActionFactory(
+            context, *config, nullptr, true);
+    }
+
+    // Headers included by many translation units
+    // are only read from disk once
+    FileSystemCache fsCache(
+        []{ return llvm::vfs::createPhysicalFileSystem(); });
+
+    // The durations of the previous run
+    // determine the order of the files
+    CostHistory history(*config, shardIndex, shardCount);
+
     auto const processFile =
         [&](std::string path)
         {
-            // Each thread gets an independent copy of a VFS to allow different
-            // concurrent working directories.
+            ExtractionCache::Entry record;
+            std::unique_ptr<tooling::FrontendActionFactory> recordAction;
+            if(cache)
+            {
+                if(auto entry = cache->lookup(path))
+                {
+                    context.report(
+                        std::move(entry->bitcode),
+                        std::move(entry->diagnostics));
+                    // loading from the cache says nothing about
+                    // the cost of extracting the file, so the
+                    // duration of the last extraction is kept
+                    return;
+                }
+                recordAction = makeFrontendActionFactory(
+                    context, *config, &record);
+            }
+
+            // only the time spent running clang is recorded
+            auto const file_start = clock_type::now();
+
+            auto const run =
+                [&](SharedPreambles::Preamble const* preamble)
+                {
+                    // Each thread gets an independent copy of a VFS to allow different
+                    // concurrent working directories. The copies share one cache.
+                    IntrusiveRefCntPtr<llvm::vfs::FileSystem> FS =
+                        fsCache.getFileSystem();
+
+                    // the paths probed by header search which did
+                    // not exist are recorded for the cache
+                    if(recordAction)
+                        FS = llvm::makeIntrusiveRefCnt<MissingFileRecorder>(
+                            std::move(FS), record.missing);
+
+                    // KRYSTIAN NOTE: ClangTool applies the SyntaxOnly, StripOutput,
+                    // and StripDependencyFile argument adjusters
+                    tooling::ClangTool Tool(compilations, { path },
+                        std::make_shared<PCHContainerOperations>(), FS);
+
+                    // suppress error messages from the tool
+                    Tool.setPrintErrorMessage(false);
+
+                    // load the preamble shared by the group of this file
+                    if(preamble)
+                    {
+                        Tool.appendArgumentsAdjuster(
+                            tooling::getInsertArgumentAdjuster({
+                                "-include-pch", preamble->pchPath,
+                                "-fretain-comments-from-system-headers" },
+                                tooling::ArgumentInsertPosition::BEGIN));
+                        // headers in the preamble are not entered
+                        // again, so record them for the cache
+                        record.dependencies.insert(
+                            record.dependencies.end(),
+                            preamble->dependencies.begin(),
+                            preamble->dependencies.end());
+                    }
+
+                    return Tool.run(recordAction ?
+                        recordAction.get() : action.get()) == 0;
+                };
+
+            auto const* preamble = preambles ?
+                preambles->find(path) : nullptr;
+            bool succeeded = run(preamble);
+            if(! succeeded && preamble)
+            {
+                // the precompiled header can fail to load, e.g.
+                // if a header changed after it was built, so
+                // the file is parsed again without it. if only
+                // the first run failed, the preamble is at fault
+                record = {};
+                succeeded = run(nullptr);
+                if(succeeded)
+                    preambles->markUnusable(*preamble, path);
+            }
+            if(! succeeded)
+                formatError("Failed to run action on {}", path).Throw();
+
+            if(cache)
+                cache->store(path, record);
+            history.record(path, clock_type::now() - file_start);
+        };
+
+    auto const processBatch =
+        [&](UnityBatch const& batch)
+        {
             IntrusiveRefCntPtr<llvm::vfs::FileSystem> FS =
-                llvm::vfs::createPhysicalFileSystem();
+                fsCache.getFileSystem();
 
-            // KRYSTIAN NOTE: ClangTool applies the SyntaxOnly, StripOutput,
-            // and StripDependencyFile argument adjusters
-            tooling::ClangTool Tool(compilations, { path },
+            tooling::ClangTool Tool(batch, { batch.path() },
                 std::make_shared<PCHContainerOperations>(), FS);
 
             // suppress error messages from the tool
             Tool.setPrintErrorMessage(false);
 
-            if(Tool.run(action.get()))
-                formatError("Failed to run action on {}", path).Throw();
+            // the main file of the batch only exists in memory
+            Tool.mapVirtualFile(batch.path(), batch.contents());
+
+            if(! Tool.run(unityAction.get()))
+                return;
+
+            // files which cannot be combined, e.g. because they
+            // define the same names with internal linkage, are
+            // extracted separately
+            report::format(reportLevel,
+                "Failed to run action on unity batch \"{}\", "
+                "extracting its {} files separately",
+                batch.path(), batch.files().size());
+            for(auto const& file : batch.files())
+                processFile(file);
         };
 
     // Run the action on all files in the database
     std::vector<Error> errors;
-    if(files.size() == 1)
+    if(files.size() == 1 && batches.empty())
     {
         try
         {
@@ -159,24 +393,89 @@ build(
     }
     else
     {
+        // Start the most expensive translation units first,
+        // so that the tail of the extraction is made of
+        // short ones which keep every thread busy
+        struct Job
+        {
+            double cost;
+            UnityBatch const* batch;
+            std::string path;
+        };
+        std::vector<Job> jobs;
+        jobs.reserve(batches.size() + files.size());
+        for(UnityBatch const& batch : batches)
+        {
+            auto const costs = history.estimate(batch.files());
+            jobs.push_back({
+                std::accumulate(costs.begin(), costs.end(), 0.0),
+                &batch, {}});
+        }
+        auto const costs = history.estimate(files);
+        std::size_t const known = history.known(files);
+        for(std::size_t i = 0; i < files.size(); ++i)
+            jobs.push_back({costs[i], nullptr, std::move(files[i])});
+        std::stable_sort(jobs.begin(), jobs.end(),
+            [](Job const& a, Job const& b)
+            {
+                return a.cost > b.cost;
+            });
+
+        std::vector<double> order;
+        order.reserve(jobs.size());
+        for(Job const& job : jobs)
+            order.push_back(job.cost);
+        double const predicted = predictMakespan(
+            order, config->threadPool().getThreadCount());
+        auto const jobs_start = clock_type::now();
+
         TaskGroup taskGroup(config->threadPool());
-        for(std::size_t index = 0;
-            std::string& file : files)
+        std::size_t const total = jobs.size();
+        std::size_t index = 0;
+        for(Job& job : jobs)
         {
+            if(job.batch)
+            {
+                taskGroup.async(
+                [&, idx = ++index, batch = job.batch]()
+                {
+                    report::format(reportLevel,
+                        "[{}/{}] \"{}\" ({} files)", idx, total,
+                        batch->path(), batch->files().size());
+
+                    processBatch(*batch);
+                });
+                continue;
+            }
             taskGroup.async(
-            [&, idx = ++index, path = std::move(file)]()
+            [&, idx = ++index, path = std::move(job.path)]()
             {
                 report::format(reportLevel,
-                    "[{}/{}] \"{}\"", idx, files.size(), path);
+                    "[{}/{}] \"{}\"", idx, total, path);
 
                 processFile(std::move(path));
             });
         }
         errors = taskGroup.wait();
+
+        report::format(reportLevel,
+            "Predicted extraction time {} ({} of {} translation "
+            "units with recorded durations), actual {}",
+            format_duration(std::chrono::duration_cast<
+                clock_type::duration>(std::chrono::duration<
+                    double, std::milli>(predicted))),
+            known, files.size(),
+            format_duration(clock_type::now() - jobs_start));
     }
+    history.save();
 
     // Report warning and error totals
     context.reportEnd(reportLevel);
+    fsCache.reportEnd(reportLevel);
+    if(cache)
+        cache->reportEnd(reportLevel);
+    if(preambles)
+        preambles->reportEnd(reportLevel);
 
     if(! errors.empty())
     {
@@ -186,11 +485,43 @@ build(
         report::warn(
             "Warning: mapping failed because ", err);
     }
+    return {};
+}
+
+} // (anon)
+
+mrdocs::Expected<std::unique_ptr<Corpus>>
+CorpusImpl::
+build(
+    report::Level reportLevel,
+    std::shared_ptr<ConfigImpl const> config,
+    tooling::CompilationDatabase const& compilations)
+{
+    auto start_time = clock_type::now();
+
+    auto corpus = std::make_unique<CorpusImpl>(config);
+
+    // Traverse the AST for all translation units
+    // and emit serializd bitcode into tool results.
+    // This operation happens ona thread pool.
+    report::print(reportLevel, "Extracting declarations");
+
+    #define USE_BITCODE
+
+    #ifdef USE_BITCODE
+        BitcodeExecutionContext context(
+            *config, (*config)->incrementalReduce,
+            std::size_t((*config)->memoryBudget) * 1024 * 1024);
+    #else
+        InfoExecutionContext context(*config);
+    #endif
+    MRDOCS_TRY(extractDeclarations(
+        reportLevel, config, compilations, context, 0, 1));
 
     #ifdef USE_BITCODE
         report::format(reportLevel,
             "Extracted {} declarations in {}",
-            context.getBitcode().size(),
+            context.symbolCount(),
             format_duration(clock_type::now() - start_time));
         start_time = clock_type::now();
 
@@ -201,7 +532,7 @@ build(
         auto results = context.results();
         if(! results)
             return Unexpected(results.error());
-        corpus->info_ = std::move(results.value());
+        corpus->info_.insert(std::move(results.value()));
 
         report::format(reportLevel,
             "Reduced {} symbols in {}",
@@ -211,7 +542,7 @@ build(
         auto results = context.results();
         if(! results)
             return Unexpected(results.error());
-        corpus->info_ = std::move(results.value());
+        corpus->info_.insert(std::move(results.value()));
 
         report::format(reportLevel,
             "Extracted {} declarations in {}",
@@ -219,9 +550,350 @@ build(
             format_duration(clock_type::now() - start_time));
     #endif
 
-    auto lookup = std::make_unique<SymbolLookup>(*corpus);
+    start_time = clock_type::now();
+    MRDOCS_TRY(auto lookup, SymbolLookup::build(
+        *corpus, config->threadPool()));
+
+    MRDOCS_TRY(finalize(corpus->info_, *lookup,
+        config->threadPool()));
+    report::format(reportLevel,
+        "Finalized {} symbols in {}",
+        corpus->info_.size(),
+        format_duration(clock_type::now() - start_time));
+    return corpus;
+}
+
+mrdocs::Expected<void>
+CorpusImpl::
+buildShard(
+    report::Level reportLevel,
+    std::shared_ptr<ConfigImpl const> config,
+    tooling::CompilationDatabase const& compilations,
+    std::size_t shardIndex,
+    std::size_t shardCount,
+    std::string_view shardPath)
+{
+    MRDOCS_ASSERT(shardIndex < shardCount);
+    auto start_time = clock_type::now();
+
+    report::format(reportLevel,
+        "Extracting declarations of shard {} of {}",
+        shardIndex, shardCount);
+
+    BitcodeExecutionContext context(*config, false,
+        std::size_t((*config)->memoryBudget) * 1024 * 1024);
+    MRDOCS_TRY(extractDeclarations(reportLevel, config,
+        compilations, context, shardIndex, shardCount));
+
+    report::format(reportLevel,
+        "Extracted {} declarations in {}",
+        context.symbolCount(),
+        format_duration(clock_type::now() - start_time));
+
+    return context.writeShard(shardPath);
+}
+
+mrdocs::Expected<std::unique_ptr<Corpus>>
+CorpusImpl::
+buildFromShards(
+    report::Level reportLevel,
+    std::shared_ptr<ConfigImpl const> config,
+    std::vector<std::string> const& shardPaths)
+{
+    auto start_time = clock_type::now();
+
+    auto corpus = std::make_unique<CorpusImpl>(config);
+
+    report::format(reportLevel,
+        "Reading {} shards", shardPaths.size());
+
+    BitcodeExecutionContext context(*config, false,
+        std::size_t((*config)->memoryBudget) * 1024 * 1024);
+    for(auto const& path : shardPaths)
+    {
+        MRDOCS_TRY(context.readShard(path));
+    }
+
+    report::format(reportLevel,
+        "Read {} declarations in {}",
+        context.symbolCount(),
+        format_duration(clock_type::now() - start_time));
+    start_time = clock_type::now();
+
+    report::format(reportLevel,
+        "Reducing declarations");
+
+    auto results = context.results();
+    if(! results)
+        return Unexpected(results.error());
+    corpus->info_.insert(std::move(results.value()));
+
+    report::format(reportLevel,
+        "Reduced {} symbols in {}",
+            corpus->info_.size(),
+            format_duration(clock_type::now() - start_time));
+
+    start_time = clock_type::now();
+    MRDOCS_TRY(auto lookup, SymbolLookup::build(
+        *corpus, config->threadPool()));
+
+    MRDOCS_TRY(finalize(corpus->info_, *lookup,
+        config->threadPool()));
+    report::format(reportLevel,
+        "Finalized {} symbols in {}",
+        corpus->info_.size(),
+        format_duration(clock_type::now() - start_time));
+    return corpus;
+}
+
+mrdocs::Expected<void>
+CorpusImpl::
+writeSnapshot(std::string_view path) const
+{
+    std::vector<Info const*> infos(info_.begin(), info_.end());
+    std::sort(infos.begin(), infos.end(),
+        [](Info const* a, Info const* b)
+        {
+            return a->id < b->id;
+        });
+
+    std::vector<llvm::SmallString<0>> bitcodes(infos.size());
+    TaskGroup taskGroup(config_->threadPool());
+    for(std::size_t i = 0; i < infos.size(); ++i)
+    {
+        taskGroup.async(
+            [&, i]
+            {
+                bitcodes[i] = writeBitcode(*infos[i]);
+            });
+    }
+    auto errors = taskGroup.wait();
+    if(! errors.empty())
+        return Unexpected(errors);
+
+    std::error_code ec;
+    llvm::raw_fd_ostream os(path, ec, llvm::sys::fs::OF_None);
+    if(ec)
+        return Unexpected(formatError(
+            "Failed to open snapshot \"{}\": {}", path, ec));
+
+    os << snapshotMagic;
+    writeInt(os, snapshotVersion);
+    writeInt(os, BitcodeVersion);
+    writeInt(os, infos.size());
+    std::uint64_t offset = 0;
+    for(std::size_t i = 0; i < infos.size(); ++i)
+    {
+        os << std::string_view(infos[i]->id);
+        writeInt(os, offset);
+        writeInt(os, bitcodes[i].size());
+        offset += bitcodes[i].size();
+    }
+    for(auto const& bitcode : bitcodes)
+        os << bitcode;
+    os.close();
+    if(os.has_error())
+    {
+        ec = os.error();
+        os.clear_error();
+        return Unexpected(formatError(
+            "Failed to write snapshot \"{}\": {}", path, ec));
+    }
+    return {};
+}
+
+mrdocs::Expected<std::unique_ptr<Corpus>>
+CorpusImpl::
+loadSnapshot(
+    report::Level reportLevel,
+    std::shared_ptr<ConfigImpl const> config,
+    std::string_view path)
+{
+    auto start_time = clock_type::now();
+
+    // the file is mapped rather than read
+    // when it is large enough
+    auto buffer = llvm::MemoryBuffer::getFile(path, false, false);
+    if(! buffer)
+        return Unexpected(formatError(
+            "Failed to open snapshot \"{}\": {}", path, buffer.getError()));
+
+    BinaryReader reader((*buffer)->getBuffer());
+    auto const invalid = [&]()
+    {
+        return Unexpected(formatError(
+            "\"{}\" is not a valid snapshot", path));
+    };
+    llvm::StringRef magic;
+    std::uint64_t version;
+    std::uint64_t bitcode_version;
+    std::uint64_t count;
+    if(! reader.readBytes(snapshotMagic.size(), magic) ||
+        magic != snapshotMagic ||
+        ! reader.readInt(version) ||
+        version != snapshotVersion ||
+        ! reader.readInt(bitcode_version))
+        return invalid();
+    if(bitcode_version != BitcodeVersion)
+        return Unexpected(formatError(
+            "Snapshot \"{}\" was written with bitcode version {} "
+            "instead of {}", path, bitcode_version, BitcodeVersion));
+    llvm::StringRef index;
+    if(! reader.readInt(count) ||
+        count > (*buffer)->getBufferSize() / snapshotEntrySize ||
+        ! reader.readBytes(count * snapshotEntrySize, index))
+        return invalid();
+    llvm::StringRef data;
+    reader.readBytes((*buffer)->getBufferEnd() - index.end(), data);
+
+    // validate the index before decoding anything. the
+    // symbols are written sorted by ID, so an entry which
+    // is out of order or repeated means a damaged index
+    std::vector<SymbolID> ids;
+    std::vector<llvm::StringRef> bitcodes;
+    ids.reserve(count);
+    bitcodes.reserve(count);
+    BinaryReader entries(index);
+    while(! entries.empty())
+    {
+        llvm::StringRef id;
+        std::uint64_t offset;
+        std::uint64_t size;
+        entries.readBytes(SymbolID().size(), id);
+        entries.readInt(offset);
+        entries.readInt(size);
+        if(offset > data.size() || size > data.size() - offset)
+            return invalid();
+        SymbolID const symbol(reinterpret_cast<
+            const std::uint8_t*>(id.data()));
+        if(! ids.empty() && ! (ids.back() < symbol))
+            return invalid();
+        ids.push_back(symbol);
+        bitcodes.push_back(data.substr(offset, size));
+    }
+
+    auto corpus = std::make_unique<CorpusImpl>(config);
+    InfoSet infos;
+    std::mutex infos_mutex;
+    std::size_t const chunk_size = std::max<std::size_t>(
+        bitcodes.size() / (config->threadPool().getThreadCount() * 4 + 1), 1);
+    TaskGroup taskGroup(config->threadPool());
+    for(std::size_t i = 0; i < bitcodes.size(); i += chunk_size)
+    {
+        taskGroup.async(
+            [&, i]
+            {
+                std::vector<std::unique_ptr<Info>> chunk;
+                std::size_t const last = std::min(
+                    i + chunk_size, bitcodes.size());
+                for(std::size_t j = i; j < last; ++j)
+                {
+                    auto decoded = readBitcode(bitcodes[j]);
+                    if(! decoded)
+                        formatError("Failed to read {} from \"{}\": {}",
+                            toBase16(ids[j]), path, decoded.error()).Throw();
+                    // each entry holds the bitcode of its symbol only
+                    if(decoded->size() != 1 ||
+                        decoded->front()->id != ids[j])
+                        formatError("The bitcode of {} in \"{}\" "
+                            "describes another symbol",
+                            toBase16(ids[j]), path).Throw();
+                    chunk.push_back(std::move(decoded->front()));
+                }
+                std::lock_guard<std::mutex> lock(infos_mutex);
+                for(auto& I : chunk)
+                    infos.emplace(std::move(I));
+            });
+    }
+    auto errors = taskGroup.wait();
+    if(! errors.empty())
+        return Unexpected(errors);
+    corpus->info_.insert(std::move(infos));
+    MRDOCS_CHECK(corpus->info_.contains(SymbolID::global),
+        formatError("\"{}\" has no global namespace", path));
+    if(auto err = checkReferences(corpus->info_))
+        return Unexpected(formatError(
+            "\"{}\" is incomplete: {}", path, err));
+
+    report::format(reportLevel,
+        "Loaded {} symbols from snapshot in {}",
+        corpus->info_.size(),
+        format_duration(clock_type::now() - start_time));
+    return corpus;
+}
+
+mrdocs::Expected<std::unique_ptr<Corpus>>
+CorpusImpl::
+buildFromBitcode(
+    report::Level reportLevel,
+    std::shared_ptr<ConfigImpl const> config,
+    std::string_view path)
+{
+    auto start_time = clock_type::now();
+
+    std::vector<std::string> files;
+    if(llvm::sys::fs::is_directory(path))
+    {
+        auto err = forEachFile(path, true,
+            [&](std::string_view file)
+            {
+                if(file.ends_with(".bc"))
+                    files.emplace_back(file);
+            });
+        if(err)
+            return Unexpected(err);
+    }
+    else
+    {
+        files.emplace_back(path);
+    }
+
+    report::format(reportLevel,
+        "Reading {} bitcode files", files.size());
+
+    InfoSet infos;
+    std::mutex infos_mutex;
+    auto errors = config->threadPool().forEach(files,
+        [&](std::string const& file)
+        {
+            auto buffer = llvm::MemoryBuffer::getFile(file, false, false);
+            if(! buffer)
+                formatError("Failed to open \"{}\": {}",
+                    file, buffer.getError()).Throw();
+            auto decoded = readBitcode((*buffer)->getBuffer());
+            if(! decoded)
+                formatError("Failed to read \"{}\": {}",
+                    file, decoded.error()).Throw();
+            std::lock_guard<std::mutex> lock(infos_mutex);
+            for(auto& I : *decoded)
+                infos.emplace(std::move(I));
+        });
+    if(! errors.empty())
+        return Unexpected(errors);
+
+    auto corpus = std::make_unique<CorpusImpl>(config);
+    corpus->info_.insert(std::move(infos));
+    MRDOCS_CHECK(corpus->info_.contains(SymbolID::global),
+        formatError("\"{}\" has no global namespace", path));
+    if(auto err = checkReferences(corpus->info_))
+        return Unexpected(formatError(
+            "\"{}\" is incomplete: {}", path, err));
+
+    report::format(reportLevel,
+        "Read {} symbols in {}",
+        corpus->info_.size(),
+        format_duration(clock_type::now() - start_time));
+
+    start_time = clock_type::now();
+    MRDOCS_TRY(auto lookup, SymbolLookup::build(
+        *corpus, config->threadPool()));
 
-    finalize(corpus->info_, *lookup);
+    MRDOCS_TRY(finalize(corpus->info_, *lookup,
+        config->threadPool()));
+    report::format(reportLevel,
+        "Finalized {} symbols in {}",
+        corpus->info_.size(),
+        format_duration(clock_type::now() - start_time));
     return corpus;
 }
 
@@ -12,6 +12,7 @@
 #define MRDOCS_LIB_CORPUSIMPL_HPP
 
 #include "lib/Lib/ConfigImpl.hpp"
+#include "lib/Lib/CorpusDiff.hpp"
 #include "lib/Lib/Info.hpp"
 #include "lib/Support/Debug.hpp"
 #include <mrdocs/Corpus.hpp>
@@ -19,8 +20,11 @@
 #include <mrdocs/Platform.hpp>
 #include <mrdocs/Support/Error.hpp>
 #include <clang/Tooling/CompilationDatabase.h>
+#include <memory>
 #include <mutex>
 #include <string>
+#include <string_view>
+#include <vector>
 
 namespace clang {
 namespace mrdocs {
@@ -62,6 +66,102 @@ public:
         std::shared_ptr<ConfigImpl const> config,
         tooling::CompilationDatabase const& compilations);
 
+    /** Extract a subset of the translation units to a shard file.
+
+        The translation units are divided into
+        `shardCount` disjoint subsets, which only
+        depend on the paths of the files. The
+        declarations extracted from the subset with
+        index `shardIndex` are written unreduced to
+        the shard file.
+
+        @param reportLevel Error reporting level.
+        @param config A shared pointer to the configuration.
+        @param compilations A compilations database for the input files.
+        @param shardIndex The zero-based index of the shard.
+        @param shardCount The number of shards.
+        @param shardPath The path of the shard file to write.
+    */
+    [[nodiscard]]
+    static
+    mrdocs::Expected<void>
+    buildShard(
+        report::Level reportLevel,
+        std::shared_ptr<ConfigImpl const> config,
+        tooling::CompilationDatabase const& compilations,
+        std::size_t shardIndex,
+        std::size_t shardCount,
+        std::string_view shardPath);
+
+    /** Build metadata from the shard files written by buildShard.
+
+        @param reportLevel Error reporting level.
+        @param config A shared pointer to the configuration.
+        @param shardPaths The paths of the shard files.
+    */
+    [[nodiscard]]
+    static
+    mrdocs::Expected<std::unique_ptr<Corpus>>
+    buildFromShards(
+        report::Level reportLevel,
+        std::shared_ptr<ConfigImpl const> config,
+        std::vector<std::string> const& shardPaths);
+
+    /** Write the symbols of the corpus to a snapshot file.
+
+        The snapshot holds an index of the symbols
+        sorted by SymbolID, followed by the bitcode
+        of each finalized symbol. It can be loaded
+        with @ref loadSnapshot without extracting
+        the translation units again.
+
+        @param path The path of the snapshot file.
+    */
+    [[nodiscard]]
+    mrdocs::Expected<void>
+    writeSnapshot(std::string_view path) const;
+
+    /** Load a corpus from a snapshot file.
+
+        Every symbol in the file is decoded before
+        this function returns, concurrently on the
+        thread pool of the configuration. The index
+        must be sorted, the bitcode of each entry must
+        describe the symbol it is indexed by, and every
+        parent and member of a symbol must be present.
+
+        @param reportLevel Error reporting level.
+        @param config A shared pointer to the configuration.
+        @param path The path of the snapshot file.
+    */
+    [[nodiscard]]
+    static
+    mrdocs::Expected<std::unique_ptr<Corpus>>
+    loadSnapshot(
+        report::Level reportLevel,
+        std::shared_ptr<ConfigImpl const> config,
+        std::string_view path);
+
+    /** Build metadata from the output of the bitcode generator.
+
+        The files are decoded concurrently on the
+        thread pool of the configuration, after which
+        lookup tables are built and the symbols are
+        finalized as for a corpus built by @ref build.
+
+        @param reportLevel Error reporting level.
+        @param config A shared pointer to the configuration.
+        @param path A directory holding one `.bc` file per
+        symbol, or a single file holding every symbol.
+    */
+    [[nodiscard]]
+    static
+    mrdocs::Expected<std::unique_ptr<Corpus>>
+    buildFromBitcode(
+        report::Level reportLevel,
+        std::shared_ptr<ConfigImpl const> config,
+        std::string_view path);
+
 private:
     Info const*
     find(
@@ -79,10 +179,18 @@ private:
 private:
     friend class Corpus;
 
+    friend
+    Expected<std::shared_ptr<SymbolHashes const>>
+    hashSymbols(Corpus const& corpus);
+
     std::shared_ptr<ConfigImpl const> config_;
 
     // Info keyed on Symbol ID.
-    InfoSet info_;
+    InfoTable info_;
+
+    // the hashes of the symbols, once computed
+    mutable std::mutex hashesMutex_;
+    mutable std::shared_ptr<SymbolHashes const> hashes_;
 };
 
 template<class T>
@@ -0,0 +1,284 @@
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+// Copyright (c) 2023 Vinnie Falco (vinnie.falco@gmail.com)
+//
+// Official repository: https://github.com/cppalliance/mrdocs
+//
+
+#include "CostHistory.hpp"
+#include <mrdocs/Support/Path.hpp>
+#include <mrdocs/Support/Error.hpp>
+#include <mrdocs/Support/ThreadPool.hpp>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/Format.h>
+#include <llvm/Support/MemoryBuffer.h>
+#include <llvm/Support/raw_ostream.h>
+#include <algorithm>
+#include <functional>
+#include <queue>
+
+namespace clang {
+namespace mrdocs {
+
+namespace {
+
+// the cost of a file without history, relative to its size
+// in bytes. each include directive is assumed to pull in
+// as much code as this many bytes of source text
+constexpr double includeWeight = 16 * 1024;
+
+// the estimated milliseconds per unit of heuristic
+// cost, used until some durations are known
+constexpr double defaultScale = 0.01;
+
+/** Return the heuristic cost of a file.
+*/
+double
+heuristicCost(std::string const& path)
+{
+    auto buffer = llvm::MemoryBuffer::getFile(path, false, false);
+    if(! buffer)
+        return 0;
+    llvm::StringRef text = (*buffer)->getBuffer();
+    std::size_t includes = 0;
+    while(! text.empty())
+    {
+        auto [line, rest] = text.split('\n');
+        text = rest;
+        line = line.ltrim();
+        if(! line.consume_front("#"))
+            continue;
+        if(line.ltrim().starts_with("include"))
+            ++includes;
+    }
+    return (*buffer)->getBufferSize() + includes * includeWeight;
+}
+
+// the name of the history of a run which is not sharded.
+// the history of each shard is named after this one
+constexpr llvm::StringLiteral historyName = "durations";
+
+} // (anon)
+
+CostHistory::
+CostHistory(
+    ConfigImpl const& config,
+    std::size_t shardIndex,
+    std::size_t shardCount)
+    : config_(config)
+{
+    if(config_->cacheDir.empty())
+        return;
+    std::string name(historyName);
+    if(shardCount > 1)
+        name += fmt::format(".{}-of-{}", shardIndex, shardCount);
+    historyPath_ = files::appendPath(
+        config_->cacheDir, name + ".txt");
+
+    // the durations of this shard take precedence
+    // over the ones recorded by other shards
+    load(historyPath_, true);
+    auto err = forEachFile(config_->cacheDir, false,
+        [&](std::string_view path) -> Error
+        {
+            llvm::StringRef file_name(files::getFileName(path));
+            if(path != historyPath_ &&
+                file_name.starts_with(historyName) &&
+                file_name.ends_with(".txt"))
+                load(std::string(path), false);
+            return Error::success();
+        });
+    if(err)
+        report::warn("Warning: failed to list the cost history: {}", err);
+}
+
+void
+CostHistory::
+load(
+    std::string const& path,
+    bool owned)
+{
+    auto buffer = llvm::MemoryBuffer::getFile(
+        path, false, false);
+    if(! buffer)
+        return;
+
+    // each line holds a duration in milliseconds
+    // and a heuristic cost, followed by a path
+    llvm::StringRef text = (*buffer)->getBuffer();
+    while(! text.empty())
+    {
+        auto [line, rest] = text.split('\n');
+        text = rest;
+        auto [ms, tail] = line.split(' ');
+        auto [heuristic, file] = tail.split(' ');
+        Cost cost;
+        if(file.empty() ||
+            ms.getAsDouble(cost.duration) ||
+            heuristic.getAsDouble(cost.heuristic))
+            continue;
+        cost.owned = owned;
+        costs_.try_emplace(file, cost);
+    }
+}
+
+std::vector<double>
+CostHistory::
+estimate(std::vector<std::string> const& paths)
+{
+    // only the files without a recorded
+    // duration are read to estimate their cost
+    std::vector<double> costs(paths.size(), -1);
+    std::vector<std::size_t> unknown;
+    double known_ms = 0;
+    double known_heuristic = 0;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for(std::size_t i = 0; i < paths.size(); ++i)
+        {
+            auto it = costs_.find(paths[i]);
+            if(it == costs_.end() ||
+                it->second.duration < 0 ||
+                it->second.heuristic < 0)
+            {
+                unknown.push_back(i);
+                continue;
+            }
+            costs[i] = it->second.duration;
+            known_ms += it->second.duration;
+            known_heuristic += it->second.heuristic;
+        }
+    }
+
+    std::vector<double> heuristic(unknown.size());
+    TaskGroup taskGroup(config_.threadPool());
+    for(std::size_t i = 0; i < unknown.size(); ++i)
+    {
+        taskGroup.async(
+            [&, i]
+            {
+                heuristic[i] = heuristicCost(paths[unknown[i]]);
+            });
+    }
+    taskGroup.wait();
+
+    double const scale = known_heuristic > 0 ?
+        known_ms / known_heuristic : defaultScale;
+    std::lock_guard<std::mutex> lock(mutex_);
+    for(std::size_t i = 0; i < unknown.size(); ++i)
+    {
+        costs[unknown[i]] = heuristic[i] * scale;
+        // kept so that the duration measured
+        // by this run can be scaled next time
+        costs_[paths[unknown[i]]].heuristic = heuristic[i];
+    }
+    return costs;
+}
+
+std::size_t
+CostHistory::
+known(std::vector<std::string> const& paths) const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return std::count_if(paths.begin(), paths.end(),
+        [&](std::string const& path)
+        {
+            auto it = costs_.find(path);
+            return it != costs_.end() &&
+                it->second.duration >= 0;
+        });
+}
+
+void
+CostHistory::
+record(
+    std::string_view path,
+    clock_type::duration duration)
+{
+    double const ms = std::chrono::duration<
+        double, std::milli>(duration).count();
+    std::lock_guard<std::mutex> lock(mutex_);
+    Cost& cost = costs_[path];
+    cost.duration = ms;
+    cost.owned = true;
+}
+
+void
+CostHistory::
+save() const
+{
+    if(historyPath_.empty())
+        return;
+    std::string const& path = historyPath_;
+
+    // write to a temporary file first so that concurrent
+    // runs never observe a partially written history
+    int fd;
+    llvm::SmallString<128> temp_path;
+    if(auto ec = llvm::sys::fs::createUniqueFile(
+        path + ".%%%%%%%%.tmp", fd, temp_path))
+    {
+        report::warn("Warning: failed to write \"{}\": {}", path, ec);
+        return;
+    }
+
+    {
+        llvm::raw_fd_ostream os(fd, true);
+        std::lock_guard<std::mutex> lock(mutex_);
+        for(auto const& entry : costs_)
+        {
+            Cost const& cost = entry.getValue();
+            if(! cost.owned ||
+                cost.duration < 0 ||
+                cost.heuristic < 0)
+                continue;
+            os << llvm::format("%.1f %.0f",
+                cost.duration, cost.heuristic)
+                << ' ' << entry.getKey() << '\n';
+        }
+        os.close();
+        if(os.has_error())
+        {
+            report::warn("Warning: failed to write \"{}\": {}",
+                path, os.error());
+            os.clear_error();
+            llvm::sys::fs::remove(temp_path);
+            return;
+        }
+    }
+
+    if(auto ec = llvm::sys::fs::rename(temp_path, path))
+    {
+        report::warn("Warning: failed to write \"{}\": {}", path, ec);
+        llvm::sys::fs::remove(temp_path);
+    }
+}
+
+//------------------------------------------------
+
+double
+predictMakespan(
+    std::vector<double> const& costs,
+    std::size_t threads)
+{
+    // the time at which each thread becomes idle
+    std::priority_queue<double,
+        std::vector<double>, std::greater<>> idle;
+    for(std::size_t i = 0; i < std::max<std::size_t>(threads, 1); ++i)
+        idle.push(0);
+    double makespan = 0;
+    for(double cost : costs)
+    {
+        double const end = idle.top() + cost;
+        idle.pop();
+        idle.push(end);
+        makespan = std::max(makespan, end);
+    }
+    return makespan;
+}
+
+} // mrdocs
+} // clang
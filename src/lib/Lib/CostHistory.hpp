@@ -0,0 +1,132 @@
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+// Copyright (c) 2023 Vinnie Falco (vinnie.falco@gmail.com)
+//
+// Official repository: https://github.com/cppalliance/mrdocs
+//
+
+#ifndef MRDOCS_LIB_COSTHISTORY_HPP
+#define MRDOCS_LIB_COSTHISTORY_HPP
+
+#include "lib/Lib/ConfigImpl.hpp"
+#include <llvm/ADT/StringMap.h>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace clang {
+namespace mrdocs {
+
+/** The time taken to extract each translation unit.
+
+    The durations measured by a run are stored in
+    the cache directory, and used by the next run
+    to start the most expensive translation units
+    first. Without a cache directory, the history
+    only lasts for the current run.
+
+    Each shard stores its durations in its own file,
+    so that concurrent shards do not overwrite each
+    other. The files of every shard are merged when
+    the history is loaded.
+*/
+class CostHistory
+{
+public:
+    using clock_type = std::chrono::steady_clock;
+
+    /** Constructor.
+
+        @param config The configuration.
+        @param shardIndex The index of the shard being extracted.
+        @param shardCount The number of shards.
+    */
+    CostHistory(
+        ConfigImpl const& config,
+        std::size_t shardIndex = 0,
+        std::size_t shardCount = 1);
+
+    /** Return the expected cost of each file, in milliseconds.
+
+        Files without a recorded duration are estimated
+        from their size and the number of `#include`
+        directives they contain, which are read on the
+        thread pool. When some files have a recorded
+        duration, the estimates are scaled to match the
+        heuristic cost recorded along with them.
+
+        @param paths The full paths to the files.
+    */
+    std::vector<double>
+    estimate(std::vector<std::string> const& paths);
+
+    /** Return the number of files with a recorded duration.
+    */
+    std::size_t
+    known(std::vector<std::string> const& paths) const;
+
+    /** Record the time taken to extract a file.
+
+        This function is thread-safe.
+    */
+    void
+    record(
+        std::string_view path,
+        clock_type::duration duration);
+
+    /** Write the history to the cache directory.
+
+        Durations recorded by earlier runs for files
+        which were not extracted by this run are kept.
+    */
+    void
+    save() const;
+
+private:
+    struct Cost
+    {
+        // the duration in milliseconds, or -1
+        double duration = -1;
+
+        // the heuristic cost, or -1
+        double heuristic = -1;
+
+        // whether the entry is written by this shard
+        bool owned = false;
+    };
+
+    void
+    load(
+        std::string const& path,
+        bool owned);
+
+    ConfigImpl const& config_;
+    std::string historyPath_;
+    mutable std::mutex mutex_;
+    llvm::StringMap<Cost> costs_;
+};
+
+/** Return the time taken to run jobs in order on a number of threads.
+
+    Each job is started on the first thread
+    to become idle.
+
+    @param costs The cost of each job, in
+    the order the jobs are started.
+
+    @param threads The number of threads.
+*/
+double
+predictMakespan(
+    std::vector<double> const& costs,
+    std::size_t threads);
+
+} // mrdocs
+} // clang
+
+#endif
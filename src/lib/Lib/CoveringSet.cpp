@@ -0,0 +1,259 @@
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+// Copyright (c) 2023 Vinnie Falco (vinnie.falco@gmail.com)
+//
+// Official repository: https://github.com/cppalliance/mrdocs
+//
+
+#include "CoveringSet.hpp"
+#include <mrdocs/Support/Path.hpp>
+#include <mrdocs/Support/ThreadPool.hpp>
+#include <clang/Tooling/DependencyScanning/DependencyScanningService.h>
+#include <clang/Tooling/DependencyScanning/DependencyScanningTool.h>
+#include <llvm/ADT/StringExtras.h>
+#include <llvm/ADT/StringMap.h>
+#include <queue>
+
+namespace clang {
+namespace mrdocs {
+
+namespace {
+
+/** Return the prerequisites listed in a make-style dependency file.
+*/
+std::vector<std::string>
+parseMakeDependencies(llvm::StringRef text)
+{
+    std::vector<std::string> deps;
+    std::string token;
+    bool seen_target = false;
+    auto const flush = [&]()
+    {
+        if(token.empty())
+            return;
+        if(seen_target)
+            deps.push_back(std::move(token));
+        else if(token.back() == ':')
+            seen_target = true;
+        token.clear();
+    };
+    for(std::size_t i = 0; i < text.size(); ++i)
+    {
+        char const c = text[i];
+        char const next = i + 1 < text.size() ? text[i + 1] : '\0';
+        if(c == '\\' && (next == '\n' || next == '\r'))
+        {
+            // line continuation
+            flush();
+            ++i;
+        }
+        else if(c == '\\' && (next == ' ' || next == '#'))
+        {
+            token.push_back(next);
+            ++i;
+        }
+        else if(c == '$' && next == '$')
+        {
+            token.push_back('$');
+            ++i;
+        }
+        else if(llvm::isSpace(c))
+        {
+            flush();
+        }
+        else
+        {
+            token.push_back(c);
+        }
+    }
+    flush();
+    return deps;
+}
+
+/** A translation unit considered for the covering set.
+*/
+struct Unit
+{
+    enum class State
+    {
+        // excluded by input.include
+        Excluded,
+        // the dependency scan failed
+        Failed,
+        // the dependency scan succeeded
+        Scanned
+    };
+
+    State state = State::Failed;
+
+    // the files in scope which are read by
+    // the translation unit, including itself
+    std::vector<std::string> paths;
+
+    // the indices of the files in scope
+    std::vector<std::size_t> covers;
+};
+
+} // (anon)
+
+std::vector<std::string>
+selectCoveringFiles(
+    ConfigImpl const& config,
+    tooling::CompilationDatabase const& compilations,
+    std::vector<std::string> files,
+    report::Level level)
+{
+    using namespace tooling::dependencies;
+
+    // the service holds the minimized sources
+    // shared by every scan
+    DependencyScanningService service(
+        ScanningMode::DependencyDirectivesScan,
+        ScanningOutputFormat::Make);
+
+    std::vector<Unit> units(files.size());
+    TaskGroup taskGroup(config.threadPool());
+    for(std::size_t i = 0; i < files.size(); ++i)
+    {
+        if(! config.shouldVisitTU(files::makePosixStyle(files[i])))
+        {
+            units[i].state = Unit::State::Excluded;
+            continue;
+        }
+        taskGroup.async(
+        [&, i]()
+        {
+            auto commands = compilations.getCompileCommands(files[i]);
+            if(commands.empty())
+                return;
+            auto const& command = commands.front();
+
+            DependencyScanningTool tool(service);
+            auto deps = tool.getDependencyFile(
+                command.CommandLine, command.Directory);
+            if(! deps)
+            {
+                llvm::consumeError(deps.takeError());
+                return;
+            }
+
+            Unit& unit = units[i];
+            for(auto const& dep : parseMakeDependencies(*deps))
+            {
+                std::string path = files::makePosixStyle(
+                    files::normalizePath(files::makeAbsolute(
+                        dep, command.Directory)));
+                std::string prefix;
+                if(config.shouldExtractFromFile(path, prefix))
+                    unit.paths.push_back(std::move(path));
+            }
+            unit.state = Unit::State::Scanned;
+        });
+    }
+    taskGroup.wait();
+
+    // assign an index to every file in scope
+    llvm::StringMap<std::size_t> ids;
+    for(Unit& unit : units)
+    {
+        for(auto const& path : unit.paths)
+            unit.covers.push_back(ids.try_emplace(
+                path, ids.size()).first->second);
+        unit.paths.clear();
+    }
+
+    // greedily select the translation unit which covers the
+    // most files not covered yet. the gains only decrease, so
+    // a gain which is still current after being popped from
+    // the queue is the largest. ties go to the earliest file
+    std::vector<bool> covered(ids.size());
+    std::vector<bool> selected(files.size());
+    std::priority_queue<std::pair<std::size_t, std::size_t>> queue;
+    for(std::size_t i = 0; i < units.size(); ++i)
+    {
+        if(units[i].state == Unit::State::Scanned &&
+            ! units[i].covers.empty())
+            queue.emplace(units[i].covers.size(), files.size() - i);
+    }
+    while(! queue.empty())
+    {
+        auto const [gain, key] = queue.top();
+        queue.pop();
+        std::size_t const i = files.size() - key;
+        std::size_t current = 0;
+        for(std::size_t id : units[i].covers)
+            current += ! covered[id];
+        if(current == 0)
+            continue;
+        if(current < gain)
+        {
+            queue.emplace(current, key);
+            continue;
+        }
+        selected[i] = true;
+        for(std::size_t id : units[i].covers)
+            covered[id] = true;
+    }
+
+    std::size_t excluded = 0;
+    std::size_t failed = 0;
+    std::size_t out_of_scope = 0;
+    std::size_t redundant = 0;
+    std::vector<std::string> result;
+    for(std::size_t i = 0; i < files.size(); ++i)
+    {
+        Unit const& unit = units[i];
+        switch(unit.state)
+        {
+        case Unit::State::Excluded:
+            ++excluded;
+            continue;
+        case Unit::State::Failed:
+            // keep translation units we know nothing about
+            ++failed;
+            break;
+        case Unit::State::Scanned:
+            if(unit.covers.empty())
+            {
+                ++out_of_scope;
+                continue;
+            }
+            if(! selected[i])
+            {
+                ++redundant;
+                continue;
+            }
+            break;
+        default:
+            MRDOCS_UNREACHABLE();
+        }
+        result.push_back(std::move(files[i]));
+    }
+
+    report::format(level,
+        "Selected {} of {} translation units covering {} files in scope",
+        result.size(), files.size(), ids.size());
+    if(excluded)
+        report::format(level,
+            "Skipped {} translation units excluded by input.include",
+            excluded);
+    if(out_of_scope)
+        report::format(level,
+            "Skipped {} translation units without files in scope",
+            out_of_scope);
+    if(redundant)
+        report::format(level,
+            "Skipped {} translation units whose files are "
+            "covered by other translation units", redundant);
+    if(failed)
+        report::format(level,
+            "Kept {} translation units which could not be scanned",
+            failed);
+    return result;
+}
+
+} // mrdocs
+} // clang
@@ -0,0 +1,65 @@
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+// Copyright (c) 2023 Vinnie Falco (vinnie.falco@gmail.com)
+//
+// Official repository: https://github.com/cppalliance/mrdocs
+//
+
+#ifndef MRDOCS_LIB_COVERINGSET_HPP
+#define MRDOCS_LIB_COVERINGSET_HPP
+
+#include "lib/Lib/ConfigImpl.hpp"
+#include <mrdocs/Support/Error.hpp>
+#include <clang/Tooling/CompilationDatabase.h>
+#include <string>
+#include <vector>
+
+namespace clang {
+namespace mrdocs {
+
+/** Return a subset of the translation units which covers every file in scope.
+
+    The dependencies of each translation unit are
+    computed with the clang dependency scanner, which
+    only preprocesses the minimized source of each file.
+    A file is in scope if it is within the source root.
+
+    Translation units excluded by `input.include`
+    or without any file in scope are dropped. The
+    remaining translation units are chosen greedily,
+    each time picking the one which includes the most
+    files in scope not yet covered, until every such
+    file is covered. Translation units which cannot
+    be scanned are always kept.
+
+    A header is considered covered by any translation
+    unit which includes it, regardless of the macros
+    in effect, so this assumes that the declarations
+    in the headers do not depend on them.
+
+    The selected files are returned in their
+    original order, and the number of translation
+    units skipped for each reason is reported.
+
+    @param config The configuration.
+
+    @param compilations The compilation database.
+
+    @param files The files in the compilation database.
+
+    @param level The level used for reporting.
+*/
+std::vector<std::string>
+selectCoveringFiles(
+    ConfigImpl const& config,
+    tooling::CompilationDatabase const& compilations,
+    std::vector<std::string> files,
+    report::Level level);
+
+} // mrdocs
+} // clang
+
+#endif
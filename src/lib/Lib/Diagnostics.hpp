@@ -40,6 +40,14 @@ public:
         messages_.emplace(std::move(s), false);
     }
 
+    /** Return each message, and whether it is an error.
+    */
+    std::unordered_map<std::string, bool> const&
+    messages() const noexcept
+    {
+        return messages_;
+    }
+
     void reportTotals(report::Level level)
     {
         if(messages_.empty())
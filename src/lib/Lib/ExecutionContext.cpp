@@ -12,14 +12,34 @@
 
 #include "ExecutionContext.hpp"
 #include "lib/AST/Bitcode.hpp"
+#include "lib/AST/BitcodeIDs.hpp"
 #include "lib/Metadata/Reduce.hpp"
+#include "lib/Support/BinaryIO.hpp"
+#include "lib/Support/Radix.hpp"
 #include <mrdocs/Metadata.hpp>
+#include <llvm/ADT/StringExtras.h>
+#include <llvm/Support/MathExtras.h>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/MemoryBuffer.h>
+#include <llvm/Support/SHA1.h>
+#include <llvm/Support/xxhash.h>
+#include <algorithm>
+#include <chrono>
 
 namespace clang {
 namespace mrdocs {
 
 namespace {
 
+// identifies a shard file, and the
+// version of the layout which follows
+constexpr llvm::StringLiteral shardMagic = "MRDOCSSH";
+constexpr std::uint64_t shardVersion = 1;
+
+// the number of bytes of bitcode read from
+// a shard before they are inserted
+constexpr std::size_t shardChunkSize = 16 * 1024 * 1024;
+
 // A standalone function to call to merge a vector of infos into one.
 // This assumes that all infos in the vector are of the same type, and will fail
 // if they are different.
@@ -45,6 +65,15 @@ void merge(Info& I, Info&& Other)
         });
 }
 
+void merge(Info& I, Info&& Other, ScopeMembers& seen)
+{
+    MRDOCS_ASSERT(I.Kind == Other.Kind);
+    visit(I, [&]<typename InfoTy>(InfoTy& II) mutable
+        {
+            merge(II, static_cast<InfoTy&&>(Other), seen);
+        });
+}
+
 } // (anon)
 
 // ----------------------------------------------------------------
@@ -81,11 +110,34 @@ report(
     diags_.mergeAndReport(std::move(diags));
 }
 
+void
+InfoExecutionContext::
+report(
+    std::vector<SerializedInfo>&& bitcode,
+    Diagnostics&& diags)
+{
+    InfoSet info;
+    for(auto& serialized : bitcode)
+    {
+        auto infos = readBitcode(serialized.bitcode);
+        if(! infos)
+        {
+            report::error("Failed to read bitcode for {}: {}",
+                toBase16(serialized.id), infos.error());
+            continue;
+        }
+        for(auto& I : *infos)
+            info.emplace(std::move(I));
+    }
+    report(std::move(info), std::move(diags));
+}
+
 void
 InfoExecutionContext::
 reportEnd(report::Level level)
 {
     diags_.reportTotals(level);
+    headers_.reportEnd(level);
 }
 
 
@@ -108,17 +160,368 @@ report(
 {
     InfoSet info = std::move(results);
 
-    std::lock_guard<std::mutex> lock(mutex_);
+    // serialize before taking any lock
+    std::vector<SerializedInfo> bitcode;
+    bitcode.reserve(info.size());
     for(auto& I : info)
+        bitcode.push_back({I->id, writeBitcode(*I)});
+
+    report(std::move(bitcode), std::move(diags));
+}
+
+void
+BitcodeExecutionContext::
+report(
+    std::vector<SerializedInfo>&& bitcode,
+    Diagnostics&& diags)
+{
+    insert(std::move(bitcode));
+
+    std::lock_guard<std::mutex> lock(diags_mutex_);
+    diags_.mergeAndReport(std::move(diags));
+}
+
+std::unique_lock<std::mutex>
+BitcodeExecutionContext::
+lock(Stripe& stripe)
+{
+    ++locks_;
+    std::unique_lock<std::mutex> lock(stripe.mutex, std::try_to_lock);
+    if(lock.owns_lock())
+        return lock;
+    ++contended_;
+    auto const start = std::chrono::steady_clock::now();
+    lock.lock();
+    wait_ns_ += std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - start).count();
+    return lock;
+}
+
+void
+BitcodeExecutionContext::
+insert(
+    std::vector<SerializedInfo>&& infos,
+    std::uint32_t shard)
+{
+    // hash the bitcode and group the symbols by stripe
+    // before locking, so that each stripe is only
+    // locked once and for as short as possible
+    std::vector<std::uint64_t> hashes;
+    hashes.reserve(infos.size());
+    std::array<std::vector<std::size_t>,
+        std::tuple_size_v<decltype(stripes_)>> groups;
+    for(std::size_t i = 0; i < infos.size(); ++i)
     {
-        auto bitcode = writeBitcode(*I);
-        auto [it, created] = bitcode_.try_emplace(I->id);
-        if(auto& codes = it->second; created ||
-            std::find(codes.begin(), codes.end(), bitcode) == codes.end())
-            codes.emplace_back(std::move(bitcode));
+        // incremental reduction uses its own digests
+        if(! incremental_)
+            hashes.push_back(llvm::xxh3_64bits(
+                llvm::arrayRefFromStringRef(infos[i].bitcode)));
+        groups[infos[i].id.data()[0] % stripes_.size()].push_back(i);
     }
 
-    diags_.mergeAndReport(std::move(diags));
+    for(std::size_t i = 0; i < stripes_.size(); ++i)
+    {
+        if(groups[i].empty())
+            continue;
+        if(incremental_)
+        {
+            reduceIncrementally(
+                stripes_[i], infos, groups[i]);
+            continue;
+        }
+        auto guard = lock(stripes_[i]);
+        for(std::size_t index : groups[i])
+            insert(stripes_[i].bitcode,
+                std::move(infos[index]), hashes[index], shard);
+    }
+
+    if(budget_ != 0 &&
+        bytes_.load() > budget_ &&
+        ! spill_failed_.load())
+        spill();
+}
+
+void
+BitcodeExecutionContext::
+insert(
+    BitcodeMap& bitcode,
+    SerializedInfo&& info,
+    std::uint64_t hash,
+    std::uint32_t shard)
+{
+    auto& blobs = bitcode[info.id];
+    for(Blob const& blob : blobs)
+    {
+        // the bytes are only compared when the hashes
+        // match, to rule out a collision
+        if(blob.hash == hash &&
+            sameBitcode(blob, info.bitcode))
+        {
+            ++duplicates_;
+            duplicate_bytes_ += info.bitcode.size();
+            return;
+        }
+    }
+    bytes_ += info.bitcode.size();
+    Blob& blob = blobs.emplace_back();
+    blob.hash = hash;
+    blob.bitcode = std::move(info.bitcode);
+    blob.shard = shard;
+}
+
+void
+BitcodeExecutionContext::
+spill()
+{
+    std::unique_lock<std::mutex> guard(spill_mutex_, std::try_to_lock);
+    // another thread is already spilling
+    if(! guard.owns_lock() || spill_buffer_)
+        return;
+    if(! spill_)
+    {
+        int fd;
+        if(auto ec = llvm::sys::fs::createTemporaryFile(
+            "mrdocs-bitcode", "spill", fd, spill_path_))
+        {
+            spill_error_ = formatError("Failed to create a file "
+                "to spill bitcode to: {}", ec);
+            spill_failed_ = true;
+            return;
+        }
+        spill_ = std::make_unique<llvm::raw_fd_ostream>(fd, true);
+        // a separate handle, so that reading the spilled
+        // bitcode does not move the position of spill_
+        auto reader = llvm::sys::fs::openNativeFileForRead(spill_path_);
+        if(! reader)
+        {
+            spill_error_ = formatError("Failed to open \"{}\": {}",
+                spill_path_.str(), llvm::toString(reader.takeError()));
+            spill_failed_ = true;
+            return;
+        }
+        spill_reader_ = *reader;
+    }
+
+    std::size_t written = 0;
+    for(Stripe& stripe : stripes_)
+    {
+        auto stripe_guard = lock(stripe);
+        for(auto& [id, blobs] : stripe.bitcode)
+        {
+            for(Blob& blob : blobs)
+            {
+                if(blob.spilled)
+                    continue;
+                blob.spilled = true;
+                blob.offset = spill_->tell();
+                blob.size = blob.bitcode.size();
+                *spill_ << blob.bitcode;
+                // keep every blob aligned
+                spill_->write_zeros(
+                    llvm::alignTo(blob.size, 8) - blob.size);
+                written += blob.size;
+                // release the memory
+                blob.bitcode = llvm::SmallString<0>();
+            }
+        }
+        // the bitcode of a blob must be readable
+        // once it is marked as spilled
+        spill_->flush();
+    }
+    bytes_ -= written;
+    spilled_bytes_ += written;
+    ++spills_;
+}
+
+mrdocs::Expected<void>
+BitcodeExecutionContext::
+mapSpillFile()
+{
+    std::lock_guard<std::mutex> guard(spill_mutex_);
+    // the bitcode could not be kept within the budget
+    if(spill_failed_)
+        return Unexpected(spill_error_);
+    if(! spill_ || spill_buffer_)
+        return {};
+    spill_->close();
+    if(spill_->has_error())
+    {
+        std::error_code ec = spill_->error();
+        spill_->clear_error();
+        return Unexpected(formatError(
+            "Failed to spill bitcode to \"{}\": {}",
+            spill_path_.str(), ec));
+    }
+    auto buffer = llvm::MemoryBuffer::getFile(
+        spill_path_, false, false);
+    if(! buffer)
+        return Unexpected(formatError(
+            "Failed to read spilled bitcode from \"{}\": {}",
+            spill_path_.str(), buffer.getError()));
+    spill_buffer_ = std::move(*buffer);
+    return {};
+}
+
+mrdocs::Expected<llvm::StringRef>
+BitcodeExecutionContext::
+getBitcode(Blob const& blob) const
+{
+    if(! blob.spilled)
+        return llvm::StringRef(blob.bitcode);
+    MRDOCS_ASSERT(spill_buffer_);
+    // the spill file may have been truncated
+    // after the bitcode was written to it
+    std::size_t const size = spill_buffer_->getBufferSize();
+    if(blob.offset > size ||
+        blob.size > size - blob.offset)
+        return Unexpected(formatError(
+            "The spilled bitcode at offset {} of \"{}\" "
+            "is past the end of the file",
+            blob.offset, spill_path_.str()));
+    return spill_buffer_->getBuffer().substr(
+        blob.offset, blob.size);
+}
+
+bool
+BitcodeExecutionContext::
+sameBitcode(
+    Blob const& blob,
+    llvm::StringRef bitcode) const
+{
+    if(! blob.spilled)
+        return blob.bitcode == bitcode;
+    if(blob.size != bitcode.size())
+        return false;
+    // read the bytes back from the spill file
+    llvm::SmallString<0> bytes;
+    bytes.resize(blob.size);
+    auto read = llvm::sys::fs::readNativeFileSlice(
+        spill_reader_, bytes, blob.offset);
+    if(! read)
+    {
+        llvm::consumeError(read.takeError());
+        return false;
+    }
+    return *read == blob.size &&
+        bytes.str() == bitcode;
+}
+
+BitcodeExecutionContext::
+~BitcodeExecutionContext()
+{
+    if(spill_reader_ != llvm::sys::fs::kInvalidFile)
+        llvm::sys::fs::closeFile(spill_reader_);
+    spill_buffer_.reset();
+    spill_.reset();
+    if(! spill_path_.empty())
+        llvm::sys::fs::remove(spill_path_);
+}
+
+void
+BitcodeExecutionContext::
+reduceIncrementally(
+    Stripe& stripe,
+    std::vector<SerializedInfo> const& infos,
+    std::vector<std::size_t> const& indices)
+{
+    // the bitcode is not kept once merged, so its
+    // duplicates are found by a digest wide enough
+    // for a collision to be ruled out
+    std::vector<Digest> digests;
+    digests.reserve(indices.size());
+    for(std::size_t index : indices)
+        digests.push_back(llvm::SHA1::hash(
+            llvm::arrayRefFromStringRef(infos[index].bitcode)));
+
+    // drop the bitcode already merged
+    std::vector<std::size_t> fresh;
+    {
+        auto guard = lock(stripe);
+        for(std::size_t i = 0; i < indices.size(); ++i)
+        {
+            auto const index = indices[i];
+            auto const it = stripe.merged.find(infos[index].id);
+            if(it != stripe.merged.end() &&
+                std::ranges::find(it->second.digests, digests[i]) !=
+                    it->second.digests.end())
+            {
+                ++duplicates_;
+                duplicate_bytes_ += infos[index].bitcode.size();
+                continue;
+            }
+            fresh.push_back(i);
+        }
+    }
+    if(fresh.empty())
+        return;
+
+    auto const start = std::chrono::steady_clock::now();
+
+    // decode without holding the lock. the digest
+    // of bitcode which cannot be decoded is not
+    // recorded, so that it is never taken as merged
+    std::vector<std::pair<std::size_t,
+        std::vector<std::unique_ptr<Info>>>> decoded;
+    for(std::size_t i : fresh)
+    {
+        auto const index = indices[i];
+        auto read = readBitcode(infos[index].bitcode);
+        if(! read)
+        {
+            std::lock_guard<std::mutex> guard(errors_mutex_);
+            errors_.push_back(formatError(
+                "Failed to read the bitcode of {}: {}",
+                toBase16(infos[index].id), read.error()));
+            continue;
+        }
+        decoded.emplace_back(i, std::move(*read));
+    }
+
+    {
+        auto guard = lock(stripe);
+        for(auto& [i, decodedInfos] : decoded)
+        {
+            auto const index = indices[i];
+            // another thread may have merged the same
+            // bitcode while this one was decoding it
+            auto& seen = stripe.merged[infos[index].id].digests;
+            if(std::ranges::find(seen, digests[i]) != seen.end())
+            {
+                ++duplicates_;
+                duplicate_bytes_ += infos[index].bitcode.size();
+                continue;
+            }
+            seen.push_back(digests[i]);
+            for(auto& I : decodedInfos)
+            {
+                auto& symbol = stripe.merged[I->id];
+                // start from an empty Info, like reduce<T>
+                if(! symbol.info)
+                    symbol.info = visit(*I, []<typename T>(T& t) ->
+                        std::unique_ptr<Info>
+                        {
+                            return std::make_unique<T>(t.id);
+                        });
+                merge(*symbol.info, std::move(*I), symbol.members);
+            }
+        }
+    }
+
+    merge_ns_ += std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - start).count();
+}
+
+std::size_t
+BitcodeExecutionContext::
+symbolCount()
+{
+    std::size_t count = 0;
+    for(Stripe& stripe : stripes_)
+    {
+        std::lock_guard<std::mutex> lock(stripe.mutex);
+        count += stripe.bitcode.size() + stripe.merged.size();
+    }
+    return count;
 }
 
 void
@@ -126,6 +529,24 @@ BitcodeExecutionContext::
 reportEnd(report::Level level)
 {
     diags_.reportTotals(level);
+    headers_.reportEnd(level);
+    report::format(level,
+        "Bitcode table: {} of {} locks contended, {} ms waiting",
+        contended_.load(), locks_.load(),
+        wait_ns_.load() / 1000000);
+    report::format(level,
+        "Dropped {} duplicate bitcode blobs, saving {:.1f} MB",
+        duplicates_.load(),
+        duplicate_bytes_.load() / (1024.0 * 1024.0));
+    if(spills_ != 0)
+        report::format(level,
+            "Spilled {:.1f} MB of bitcode to disk in {} passes",
+            spilled_bytes_ / (1024.0 * 1024.0), spills_);
+    if(incremental_)
+        report::format(level,
+            "Merged symbols during extraction, overlapping {} ms "
+            "of reduction with extraction",
+            merge_ns_.load() / 1000000);
 }
 
 mrdocs::Expected<InfoSet>
@@ -133,36 +554,197 @@ BitcodeExecutionContext::
 results()
 {
     InfoSet result;
-    auto errors = config_.threadPool().forEach(
-        bitcode_,
-        [&](auto& Group)
+    if(incremental_)
+    {
+        // bitcode which could not be decoded
+        // while extraction was running
         {
-            // One or more Info for the same symbol ID
-            std::vector<std::unique_ptr<Info>> Infos;
+            std::lock_guard<std::mutex> guard(errors_mutex_);
+            if(! errors_.empty())
+                return Unexpected(Error(errors_));
+        }
 
-            // Each Bitcode can have multiple Infos
-            for(auto& bitcode : Group.second)
+        // every symbol was merged as it was reported
+        for(Stripe& stripe : stripes_)
+        {
+            for(auto& [id, symbol] : stripe.merged)
             {
-                auto infos = readBitcode(bitcode);
-                std::move(
-                    infos->begin(),
-                    infos->end(),
-                    std::back_inserter(Infos));
+                if(symbol.info)
+                    result.emplace(std::move(symbol.info));
             }
+            stripe.merged.clear();
+        }
+        return result;
+    }
 
-            auto merged = mergeInfos(Infos);
-            std::unique_ptr<Info> I = std::move(merged.value());
-            MRDOCS_ASSERT(I);
-            MRDOCS_ASSERT(Group.first == I->id);
-            std::lock_guard<std::mutex> lock(mutex_);
-            result.emplace(std::move(I));
-        });
+    MRDOCS_TRY(mapSpillFile());
+    std::mutex result_mutex;
+    TaskGroup taskGroup(config_.threadPool());
+    for(Stripe& stripe : stripes_)
+    {
+        for(auto& Group : stripe.bitcode)
+        {
+            taskGroup.async(
+            [&]()
+            {
+                // One or more Info for the same symbol ID
+                std::vector<std::unique_ptr<Info>> Infos;
+
+                // Each Bitcode can have multiple Infos
+                for(auto& blob : Group.second)
+                {
+                    auto bitcode = getBitcode(blob);
+                    if(! bitcode)
+                        bitcode.error().Throw();
+                    auto infos = readBitcode(*bitcode);
+                    if(! infos)
+                    {
+                        if(blob.shard == 0)
+                            formatError(
+                                "Failed to read the bitcode of {}: {}",
+                                toBase16(Group.first), infos.error()).Throw();
+                        formatError(
+                            "Failed to read the bitcode of {} from \"{}\": {}",
+                            toBase16(Group.first), shards_[blob.shard - 1],
+                            infos.error()).Throw();
+                    }
+                    std::move(
+                        infos->begin(),
+                        infos->end(),
+                        std::back_inserter(Infos));
+                }
+
+                auto merged = mergeInfos(Infos);
+                if(! merged)
+                    formatError("Failed to merge {}: {}",
+                        toBase16(Group.first), merged.error()).Throw();
+                std::unique_ptr<Info> I = std::move(*merged);
+                if(! I || I->id != Group.first)
+                    formatError("The bitcode of {} describes another symbol",
+                        toBase16(Group.first)).Throw();
+                std::lock_guard<std::mutex> lock(result_mutex);
+                result.emplace(std::move(I));
+            });
+        }
+    }
+    auto errors = taskGroup.wait();
 
     if(! errors.empty())
         return Unexpected(errors);
     return result;
 }
 
+mrdocs::Expected<void>
+BitcodeExecutionContext::
+writeShard(std::string_view path)
+{
+    MRDOCS_ASSERT(! incremental_);
+    MRDOCS_TRY(mapSpillFile());
+    std::error_code ec;
+    llvm::raw_fd_ostream os(path, ec, llvm::sys::fs::OF_None);
+    if(ec)
+        return Unexpected(formatError(
+            "Failed to open shard \"{}\": {}", path, ec));
+
+    os << shardMagic;
+    writeInt(os, shardVersion);
+    writeInt(os, BitcodeVersion);
+    writeInt(os, symbolCount());
+    for(Stripe& stripe : stripes_)
+    {
+        std::lock_guard<std::mutex> lock(stripe.mutex);
+        for(auto const& [id, codes] : stripe.bitcode)
+        {
+            os << std::string_view(id);
+            writeInt(os, codes.size());
+            for(auto const& blob : codes)
+            {
+                MRDOCS_TRY(auto bitcode, getBitcode(blob));
+                writeString(os, bitcode);
+            }
+        }
+    }
+    os.close();
+    if(os.has_error())
+    {
+        ec = os.error();
+        os.clear_error();
+        return Unexpected(formatError(
+            "Failed to write shard \"{}\": {}", path, ec));
+    }
+    return {};
+}
+
+mrdocs::Expected<void>
+BitcodeExecutionContext::
+readShard(std::string_view path)
+{
+    auto buffer = llvm::MemoryBuffer::getFile(path, false, false);
+    if(! buffer)
+        return Unexpected(formatError(
+            "Failed to open shard \"{}\": {}", path, buffer.getError()));
+
+    // the index of the shard is recorded with its bitcode,
+    // so that errors when decoding it name the shard
+    shards_.emplace_back(path);
+    auto const shard = static_cast<std::uint32_t>(shards_.size());
+
+    BinaryReader reader((*buffer)->getBuffer());
+    auto const invalid = [&]()
+    {
+        return Unexpected(formatError(
+            "\"{}\" is not a valid shard", path));
+    };
+    llvm::StringRef magic;
+    std::uint64_t version;
+    std::uint64_t bitcode_version;
+    if(! reader.readBytes(shardMagic.size(), magic) ||
+        magic != shardMagic ||
+        ! reader.readInt(version) ||
+        version != shardVersion ||
+        ! reader.readInt(bitcode_version))
+        return invalid();
+    if(bitcode_version != BitcodeVersion)
+        return Unexpected(formatError(
+            "Shard \"{}\" was written with bitcode version {} "
+            "instead of {}", path, bitcode_version, BitcodeVersion));
+
+    std::uint64_t groups;
+    if(! reader.readInt(groups))
+        return invalid();
+    // the bitcode is inserted in chunks, so that the
+    // memory budget is respected while reading a shard
+    std::size_t const chunk_limit = budget_ != 0 ?
+        std::min(budget_ / 4 + 1, shardChunkSize) :
+        shardChunkSize;
+    std::vector<SerializedInfo> infos;
+    std::size_t chunk_bytes = 0;
+    while(groups--)
+    {
+        llvm::StringRef id;
+        std::uint64_t count;
+        if(! reader.readBytes(SymbolID().size(), id) ||
+            ! reader.readInt(count))
+            return invalid();
+        SymbolID const symbol(reinterpret_cast<
+            const std::uint8_t*>(id.data()));
+        while(count--)
+        {
+            llvm::StringRef bitcode;
+            if(! reader.readString(bitcode))
+                return invalid();
+            infos.push_back({symbol, llvm::SmallString<0>(bitcode)});
+            chunk_bytes += bitcode.size();
+            if(chunk_bytes < chunk_limit)
+                continue;
+            insert(std::move(infos), shard);
+            infos.clear();
+            chunk_bytes = 0;
+        }
+    }
+    insert(std::move(infos), shard);
+    return {};
+}
 
 } // mrdocs
 } // clang
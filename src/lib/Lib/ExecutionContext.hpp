@@ -15,11 +15,22 @@
 
 #include "ConfigImpl.hpp"
 #include "Diagnostics.hpp"
+#include "HeaderRegistry.hpp"
 #include "Info.hpp"
+#include "lib/AST/Bitcode.hpp"
+#include "lib/Metadata/Reduce.hpp"
 #include <mrdocs/Support/Error.hpp>
 #include <llvm/ADT/SmallString.h>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/MemoryBuffer.h>
+#include <llvm/Support/raw_ostream.h>
+#include <array>
+#include <atomic>
+#include <cstdint>
 #include <mutex>
 #include <shared_mutex>
+#include <string>
+#include <string_view>
 #include <unordered_map>
 #include <vector>
 
@@ -37,6 +48,7 @@ class ExecutionContext
 {
 protected:
     const ConfigImpl& config_;
+    HeaderRegistry headers_;
 
 public:
     ExecutionContext(
@@ -45,12 +57,28 @@ public:
     {
     }
 
+    /** Return the registry of extracted headers.
+    */
+    HeaderRegistry&
+    headers() noexcept
+    {
+        return headers_;
+    }
+
     virtual
     void
     report(
         InfoSet&& info,
         Diagnostics&& diags) = 0;
 
+    /** Report the results of a translation unit as bitcode.
+    */
+    virtual
+    void
+    report(
+        std::vector<SerializedInfo>&& bitcode,
+        Diagnostics&& diags) = 0;
+
     virtual
     void
     reportEnd(report::Level level) = 0;
@@ -79,6 +107,11 @@ public:
         InfoSet&& info,
         Diagnostics&& diags) override;
 
+    void
+    report(
+        std::vector<SerializedInfo>&& bitcode,
+        Diagnostics&& diags) override;
+
     void
     reportEnd(report::Level level) override;
 
@@ -91,30 +124,205 @@ public:
 class BitcodeExecutionContext
     : public ExecutionContext
 {
-    std::mutex mutex_;
+    /** The bitcode of a symbol reported by a translation unit.
+
+        Many translation units report identical bitcode
+        for the symbols in shared headers. The hash of
+        the bitcode is compared first, so that duplicates
+        are found without comparing every byte.
+    */
+    struct Blob
+    {
+        std::uint64_t hash;
+        llvm::SmallString<0> bitcode;
+
+        // the location of the bitcode in the spill
+        // file, once it is no longer held in memory
+        bool spilled = false;
+        std::uint64_t offset = 0;
+        std::uint64_t size = 0;
+
+        // one plus the index of the shard the bitcode
+        // was read from, or zero if it was reported
+        // by a translation unit
+        std::uint32_t shard = 0;
+    };
+
+    using BitcodeMap = std::unordered_map<
+        SymbolID, std::vector<Blob>>;
+
+    /** The SHA1 digest of a bitcode blob.
+    */
+    using Digest = std::array<std::uint8_t, 20>;
+
+    /** The result of merging the reported Infos of a symbol.
+
+        Used instead of the bitcode when reducing
+        incrementally. The digests of the merged bitcode
+        are kept to drop duplicates, and the members of
+        a scope are kept so that they are not hashed
+        again on every merge.
+    */
+    struct MergedSymbol
+    {
+        std::vector<Digest> digests;
+        std::unique_ptr<Info> info;
+        ScopeMembers members;
+    };
+
+    /** A part of the bitcode table with its own lock.
+
+        Symbols are assigned to a stripe by the first byte
+        of their ID, so threads reporting the results of
+        different translation units rarely wait on each
+        other.
+    */
+    struct Stripe
+    {
+        std::mutex mutex;
+        BitcodeMap bitcode;
+        std::unordered_map<SymbolID, MergedSymbol> merged;
+    };
+
+    std::array<Stripe, 64> stripes_;
+    bool incremental_ = false;
+
+    std::mutex diags_mutex_;
     Diagnostics diags_;
 
-    std::unordered_map<SymbolID,
-        std::vector<llvm::SmallString<0>>> bitcode_;
+    // the number of times a stripe was locked, how
+    // many of them had to wait, and for how long
+    std::atomic<std::size_t> locks_ = 0;
+    std::atomic<std::size_t> contended_ = 0;
+    std::atomic<std::int64_t> wait_ns_ = 0;
+
+    // the number and size of the duplicate blobs dropped
+    std::atomic<std::size_t> duplicates_ = 0;
+    std::atomic<std::size_t> duplicate_bytes_ = 0;
+
+    // the time spent merging while extraction was running
+    std::atomic<std::int64_t> merge_ns_ = 0;
+
+    // the bitcode which could not be decoded
+    // while reducing incrementally
+    std::mutex errors_mutex_;
+    std::vector<Error> errors_;
+
+    // the bitcode held in memory is appended to the spill
+    // file whenever its size exceeds the budget. the file
+    // is mapped into memory once extraction is complete
+    std::size_t budget_ = 0;
+    std::atomic<std::size_t> bytes_ = 0;
+    std::atomic<bool> spill_failed_ = false;
+    std::mutex spill_mutex_;
+    Error spill_error_;
+    llvm::SmallString<128> spill_path_;
+    std::unique_ptr<llvm::raw_fd_ostream> spill_;
+    llvm::sys::fs::file_t spill_reader_ = llvm::sys::fs::kInvalidFile;
+    std::unique_ptr<llvm::MemoryBuffer> spill_buffer_;
+    std::size_t spilled_bytes_ = 0;
+    std::size_t spills_ = 0;
+
+    // the paths of the shards read
+    std::vector<std::string> shards_;
+
+    std::unique_lock<std::mutex>
+    lock(Stripe& stripe);
+
+    void
+    insert(
+        std::vector<SerializedInfo>&& infos,
+        std::uint32_t shard = 0);
+
+    void
+    insert(
+        BitcodeMap& bitcode,
+        SerializedInfo&& info,
+        std::uint64_t hash,
+        std::uint32_t shard);
+
+    void
+    spill();
+
+    mrdocs::Expected<void>
+    mapSpillFile();
+
+    mrdocs::Expected<llvm::StringRef>
+    getBitcode(Blob const& blob) const;
+
+    bool
+    sameBitcode(
+        Blob const& blob,
+        llvm::StringRef bitcode) const;
+
+    void
+    reduceIncrementally(
+        Stripe& stripe,
+        std::vector<SerializedInfo> const& infos,
+        std::vector<std::size_t> const& indices);
 
 public:
-    using ExecutionContext::ExecutionContext;
+    /** Constructor.
+
+        @param config The configuration.
+
+        @param incremental If `true`, the bitcode of
+        each symbol is merged as soon as it is reported,
+        and only the merged Info is kept. Shard files
+        cannot be written in this mode.
+
+        @param memoryBudget The number of bytes of
+        bitcode kept in memory before it is written
+        to a temporary file, or zero for no limit.
+        Unused when reducing incrementally.
+    */
+    explicit
+    BitcodeExecutionContext(
+        const ConfigImpl& config,
+        bool incremental = false,
+        std::size_t memoryBudget = 0)
+        : ExecutionContext(config)
+        , incremental_(incremental)
+        , budget_(memoryBudget)
+    {
+    }
+
+    ~BitcodeExecutionContext();
 
     void
     report(
         InfoSet&& info,
         Diagnostics&& diags) override;
 
+    void
+    report(
+        std::vector<SerializedInfo>&& bitcode,
+        Diagnostics&& diags) override;
+
     void
     reportEnd(report::Level level) override;
 
     mrdocs::Expected<InfoSet>
     results() override;
 
-    auto& getBitcode()
-    {
-        return bitcode_;
-    }
+    /** Write the bitcode of every symbol to a shard file.
+
+        A shard file holds the unreduced results of
+        a subset of the translation units, so that
+        the extraction can be split between processes.
+    */
+    mrdocs::Expected<void>
+    writeShard(std::string_view path);
+
+    /** Add the bitcode stored in a shard file.
+    */
+    mrdocs::Expected<void>
+    readShard(std::string_view path);
+
+    /** Return the number of distinct symbols reported.
+    */
+    std::size_t
+    symbolCount();
 };
 
 
@@ -0,0 +1,338 @@
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+// Copyright (c) 2023 Vinnie Falco (vinnie.falco@gmail.com)
+//
+// Official repository: https://github.com/cppalliance/mrdocs
+//
+
+#include "ExtractionCache.hpp"
+#include "lib/AST/BitcodeIDs.hpp"
+#include "lib/Support/BinaryIO.hpp"
+#include <mrdocs/Support/Path.hpp>
+#include <mrdocs/Version.hpp>
+#include <llvm/ADT/StringExtras.h>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/MemoryBuffer.h>
+#include <llvm/Support/SHA1.h>
+#include <llvm/Support/raw_ostream.h>
+#include <llvm/Support/xxhash.h>
+
+namespace clang {
+namespace mrdocs {
+
+namespace {
+
+// identifies an entry file, and the
+// version of the layout which follows
+constexpr llvm::StringLiteral entryMagic = "MRDOCSTU";
+constexpr std::uint32_t entryVersion = 3;
+
+} // (anon)
+
+ExtractionCache::
+ExtractionCache(
+    ConfigImpl const& config,
+    tooling::CompilationDatabase const& compilations)
+    : config_(config)
+    , compilations_(compilations)
+{
+    if(auto err = files::createDirectory(config_->cacheDir))
+        report::warn("Warning: failed to create the cache directory: {}", err);
+}
+
+std::uint64_t
+ExtractionCache::
+hashContents(llvm::StringRef contents) noexcept
+{
+    return llvm::xxh3_64bits(
+        llvm::arrayRefFromStringRef(contents));
+}
+
+std::string
+ExtractionCache::
+entryPath(std::string_view path) const
+{
+    llvm::SHA1 hasher;
+    auto const update = [&](llvm::StringRef str)
+    {
+        hasher.update(str);
+        // separate the fields so that
+        // adjacent strings cannot collide
+        hasher.update(llvm::StringRef("\0", 1));
+    };
+    update(project_version);
+    update(std::to_string(BitcodeVersion));
+    update(config_->configYaml);
+    update(config_->extraYaml);
+    update(path);
+    for(auto const& cmd : compilations_.getCompileCommands(path))
+    {
+        update(cmd.Directory);
+        for(auto const& arg : cmd.CommandLine)
+            update(arg);
+    }
+    auto const digest = hasher.final();
+    return files::appendPath(config_->cacheDir,
+        llvm::toHex(digest, true) + ".mrdocs-tu");
+}
+
+std::optional<ExtractionCache::Entry>
+ExtractionCache::
+lookup(std::string_view path)
+{
+    auto const miss = [&]() -> std::optional<Entry>
+    {
+        ++misses_;
+        return std::nullopt;
+    };
+
+    auto buffer = llvm::MemoryBuffer::getFile(
+        entryPath(path), false, false);
+    if(! buffer)
+        return miss();
+
+    // an entry which was partially written, or
+    // damaged, fails the checksum of its contents.
+    // the path guards against colliding keys
+    BinaryReader reader((*buffer)->getBuffer());
+    llvm::StringRef magic;
+    std::uint64_t version;
+    std::uint64_t checksum;
+    llvm::StringRef entry_path;
+    if(! reader.readBytes(entryMagic.size(), magic) ||
+        magic != entryMagic ||
+        ! reader.readInt(version) ||
+        version != entryVersion ||
+        ! reader.readInt(checksum) ||
+        hashContents(reader.remaining()) != checksum ||
+        ! reader.readString(entry_path) ||
+        entry_path != llvm::StringRef(path))
+        return miss();
+
+    Entry entry;
+    std::uint64_t count;
+    if(! reader.readInt(count))
+        return miss();
+    entry.dependencies.reserve(count);
+    while(count--)
+    {
+        Dependency& dep = entry.dependencies.emplace_back();
+        llvm::StringRef dep_path;
+        if(! reader.readString(dep_path) ||
+            ! reader.readInt(dep.hash))
+            return miss();
+        dep.path = dep_path.str();
+
+        // the entry is stale if any file read
+        // by the translation unit has changed
+        auto contents = llvm::MemoryBuffer::getFile(
+            dep.path, false, false);
+        if(! contents || hashContents(
+            (*contents)->getBuffer()) != dep.hash)
+            return miss();
+    }
+
+    if(! reader.readInt(count))
+        return miss();
+    entry.missing.reserve(count);
+    while(count--)
+    {
+        llvm::StringRef missing_path;
+        if(! reader.readString(missing_path))
+            return miss();
+        // the entry is stale if a file which
+        // was looked up now exists
+        if(llvm::sys::fs::exists(missing_path))
+            return miss();
+        entry.missing.push_back(missing_path.str());
+    }
+
+    if(! reader.readInt(count))
+        return miss();
+    while(count--)
+    {
+        std::uint64_t is_error;
+        llvm::StringRef message;
+        if(! reader.readInt(is_error) ||
+            ! reader.readString(message))
+            return miss();
+        if(is_error)
+            entry.diagnostics.error(message.str());
+        else
+            entry.diagnostics.warn(message.str());
+    }
+
+    if(! reader.readInt(count))
+        return miss();
+    entry.bitcode.reserve(count);
+    while(count--)
+    {
+        llvm::StringRef id;
+        llvm::StringRef bitcode;
+        if(! reader.readBytes(SymbolID().size(), id) ||
+            ! reader.readString(bitcode))
+            return miss();
+        entry.bitcode.push_back({
+            SymbolID(reinterpret_cast<
+                const std::uint8_t*>(id.data())),
+            llvm::SmallString<0>(bitcode)});
+    }
+    if(! reader.empty())
+        return miss();
+    ++hits_;
+    return entry;
+}
+
+void
+ExtractionCache::
+store(
+    std::string_view path,
+    Entry const& entry)
+{
+    std::string entry_path = entryPath(path);
+
+    // write to a temporary file first so that concurrent
+    // runs never observe a partially written entry
+    int fd;
+    llvm::SmallString<128> temp_path;
+    if(auto ec = llvm::sys::fs::createUniqueFile(
+        entry_path + ".%%%%%%%%.tmp", fd, temp_path))
+    {
+        report::warn("Warning: failed to write cache entry \"{}\": {}",
+            entry_path, ec);
+        return;
+    }
+
+    // the contents follow their checksum
+    std::string contents;
+    {
+        llvm::raw_string_ostream os(contents);
+        writeString(os, path);
+        writeInt(os, entry.dependencies.size());
+        for(auto const& dep : entry.dependencies)
+        {
+            writeString(os, dep.path);
+            writeInt(os, dep.hash);
+        }
+        writeInt(os, entry.missing.size());
+        for(auto const& missing_path : entry.missing)
+            writeString(os, missing_path);
+        auto const& messages = entry.diagnostics.messages();
+        writeInt(os, messages.size());
+        for(auto const& [message, is_error] : messages)
+        {
+            writeInt(os, is_error);
+            writeString(os, message);
+        }
+        writeInt(os, entry.bitcode.size());
+        for(auto const& info : entry.bitcode)
+        {
+            os << std::string_view(info.id);
+            writeString(os, info.bitcode);
+        }
+    }
+
+    {
+        llvm::raw_fd_ostream os(fd, true);
+        os << entryMagic;
+        writeInt(os, entryVersion);
+        writeInt(os, hashContents(contents));
+        os << contents;
+        os.close();
+        if(os.has_error())
+        {
+            report::warn("Warning: failed to write cache entry \"{}\": {}",
+                entry_path, os.error());
+            os.clear_error();
+            llvm::sys::fs::remove(temp_path);
+            return;
+        }
+    }
+
+    if(auto ec = llvm::sys::fs::rename(temp_path, entry_path))
+    {
+        report::warn("Warning: failed to write cache entry \"{}\": {}",
+            entry_path, ec);
+        llvm::sys::fs::remove(temp_path);
+    }
+}
+
+void
+MissingFileRecorder::
+record(const llvm::Twine& Path)
+{
+    llvm::SmallString<256> path;
+    Path.toVector(path);
+    if(makeAbsolute(path))
+        return;
+    if(seen_.insert(path).second)
+        missing_.push_back(path.str().str());
+}
+
+llvm::ErrorOr<llvm::vfs::Status>
+MissingFileRecorder::
+status(const llvm::Twine& Path)
+{
+    auto result = ProxyFileSystem::status(Path);
+    if(! result && result.getError() ==
+        std::errc::no_such_file_or_directory)
+        record(Path);
+    return result;
+}
+
+llvm::ErrorOr<std::unique_ptr<llvm::vfs::File>>
+MissingFileRecorder::
+openFileForRead(const llvm::Twine& Path)
+{
+    auto result = ProxyFileSystem::openFileForRead(Path);
+    if(! result && result.getError() ==
+        std::errc::no_such_file_or_directory)
+        record(Path);
+    return result;
+}
+
+void
+IncludeHasher::
+FileChanged(
+    clang::SourceLocation Loc,
+    FileChangeReason Reason,
+    SrcMgr::CharacteristicKind,
+    FileID)
+{
+    if(Reason != FileChangeReason::EnterFile)
+        return;
+    FileID FID = source_.getFileID(Loc);
+    const FileEntry* file = source_.getFileEntryForID(FID);
+    if(! file || ! seen_.insert(file).second)
+        return;
+    // "try" implies this may fail, so fallback to getName
+    // if an empty string is returned
+    llvm::StringRef file_path = file->tryGetRealPathName();
+    if(file_path.empty())
+        file_path = file->getName();
+    dependencies_.push_back({
+        file_path.str(),
+        ExtractionCache::hashContents(
+            source_.getBufferData(FID))});
+}
+
+//------------------------------------------------
+
+void
+ExtractionCache::
+reportEnd(report::Level level) const
+{
+    std::size_t const hits = hits_.load();
+    std::size_t const misses = misses_.load();
+    if(hits == 0 && misses == 0)
+        return;
+    report::format(level,
+        "Extraction cache: {} hits, {} misses",
+        hits, misses);
+}
+
+} // mrdocs
+} // clang
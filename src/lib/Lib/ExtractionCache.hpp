@@ -0,0 +1,200 @@
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+// Copyright (c) 2023 Vinnie Falco (vinnie.falco@gmail.com)
+//
+// Official repository: https://github.com/cppalliance/mrdocs
+//
+
+#ifndef MRDOCS_LIB_EXTRACTIONCACHE_HPP
+#define MRDOCS_LIB_EXTRACTIONCACHE_HPP
+
+#include "lib/AST/Bitcode.hpp"
+#include "lib/Lib/ConfigImpl.hpp"
+#include "lib/Lib/Diagnostics.hpp"
+#include <mrdocs/Support/Error.hpp>
+#include <clang/Basic/SourceManager.h>
+#include <clang/Lex/PPCallbacks.h>
+#include <clang/Tooling/CompilationDatabase.h>
+#include <llvm/ADT/SmallPtrSet.h>
+#include <llvm/ADT/StringRef.h>
+#include <llvm/ADT/StringSet.h>
+#include <llvm/Support/VirtualFileSystem.h>
+#include <atomic>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace clang {
+namespace mrdocs {
+
+/** A persistent cache of the extraction results of each translation unit.
+
+    Each entry is stored in its own file in the cache
+    directory, named after a key derived from the path
+    of the translation unit, its command line, the
+    configuration, and the version of the bitcode format.
+
+    An entry records the contents hash of every file
+    read while the translation unit was parsed, and
+    the paths which were looked up but did not exist.
+    It is only used when all of these files are
+    unchanged, and none of the missing files were
+    created, e.g. a header which would now shadow
+    the one found by an include directive. An entry
+    whose contents do not match their checksum, such
+    as one damaged on disk, is treated as missing.
+*/
+class ExtractionCache
+{
+public:
+    /** A file read by a translation unit.
+    */
+    struct Dependency
+    {
+        /** The full path to the file.
+        */
+        std::string path;
+
+        /** The hash of the contents of the file.
+        */
+        std::uint64_t hash = 0;
+    };
+
+    /** The extraction results for a translation unit.
+    */
+    struct Entry
+    {
+        /** The files read by the translation unit.
+        */
+        std::vector<Dependency> dependencies;
+
+        /** The full paths looked up by the translation unit which did not exist.
+        */
+        std::vector<std::string> missing;
+
+        /** The diagnostics emitted by the extraction.
+        */
+        Diagnostics diagnostics;
+
+        /** The bitcode for every extracted symbol.
+        */
+        std::vector<SerializedInfo> bitcode;
+    };
+
+    ExtractionCache(
+        ConfigImpl const& config,
+        tooling::CompilationDatabase const& compilations);
+
+    /** Return the hash of the contents of a file.
+    */
+    static
+    std::uint64_t
+    hashContents(llvm::StringRef contents) noexcept;
+
+    /** Return the cached results for a translation unit.
+
+        @return The entry, or `std::nullopt` if there
+        is no entry or any of its dependencies changed.
+
+        @param path The path to the translation unit,
+        as returned by the compilation database.
+    */
+    std::optional<Entry>
+    lookup(std::string_view path);
+
+    /** Store the results for a translation unit.
+
+        Failure to write the entry is reported
+        as a warning and is otherwise ignored.
+
+        @param path The path to the translation unit,
+        as returned by the compilation database.
+
+        @param entry The results to store.
+    */
+    void
+    store(
+        std::string_view path,
+        Entry const& entry);
+
+    /** Report the number of hits and misses.
+    */
+    void
+    reportEnd(report::Level level) const;
+
+private:
+    std::string
+    entryPath(std::string_view path) const;
+
+    ConfigImpl const& config_;
+    tooling::CompilationDatabase const& compilations_;
+    std::atomic<std::size_t> hits_ = 0;
+    std::atomic<std::size_t> misses_ = 0;
+};
+
+/** Records the paths which are looked up but do not exist.
+
+    Header search probes every include directory in
+    turn, so the paths which did not exist before the
+    header was found are recorded by the file system.
+*/
+class MissingFileRecorder
+    : public llvm::vfs::ProxyFileSystem
+{
+    llvm::StringSet<> seen_;
+    std::vector<std::string>& missing_;
+
+    void
+    record(const llvm::Twine& Path);
+
+public:
+    MissingFileRecorder(
+        llvm::IntrusiveRefCntPtr<llvm::vfs::FileSystem> FS,
+        std::vector<std::string>& missing)
+        : ProxyFileSystem(std::move(FS))
+        , missing_(missing)
+    {
+    }
+
+    llvm::ErrorOr<llvm::vfs::Status>
+    status(const llvm::Twine& Path) override;
+
+    llvm::ErrorOr<std::unique_ptr<llvm::vfs::File>>
+    openFileForRead(const llvm::Twine& Path) override;
+};
+
+/** Records the contents hash of every file entered by the preprocessor.
+*/
+class IncludeHasher
+    : public PPCallbacks
+{
+    const SourceManager& source_;
+    llvm::SmallPtrSet<const FileEntry*, 32> seen_;
+    std::vector<ExtractionCache::Dependency>& dependencies_;
+
+public:
+    IncludeHasher(
+        const SourceManager& source,
+        std::vector<ExtractionCache::Dependency>& dependencies)
+        : source_(source)
+        , dependencies_(dependencies)
+    {
+    }
+
+    void
+    FileChanged(
+        clang::SourceLocation Loc,
+        FileChangeReason Reason,
+        SrcMgr::CharacteristicKind FileType,
+        FileID PrevFID) override;
+};
+
+} // mrdocs
+} // clang
+
+#endif
@@ -0,0 +1,73 @@
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+// Copyright (c) 2023 Vinnie Falco (vinnie.falco@gmail.com)
+//
+// Official repository: https://github.com/cppalliance/mrdocs
+//
+
+#include "HeaderRegistry.hpp"
+#include <fmt/format.h>
+
+namespace clang {
+namespace mrdocs {
+
+namespace {
+
+std::string
+makeKey(
+    std::string_view path,
+    std::uint64_t fingerprint)
+{
+    return fmt::format("{}:{:016x}", path, fingerprint);
+}
+
+} // (anon)
+
+bool
+HeaderRegistry::
+contains(
+    std::string_view path,
+    std::uint64_t fingerprint)
+{
+    std::string const key = makeKey(path, fingerprint);
+    bool found;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        found = extracted_.contains(key);
+    }
+    if(found)
+        ++hits_;
+    else
+        ++misses_;
+    return found;
+}
+
+void
+HeaderRegistry::
+insert(
+    std::string_view path,
+    std::uint64_t fingerprint)
+{
+    std::string key = makeKey(path, fingerprint);
+    std::lock_guard<std::mutex> lock(mutex_);
+    extracted_.emplace(std::move(key));
+}
+
+void
+HeaderRegistry::
+reportEnd(report::Level level) const
+{
+    std::size_t const hits = hits_.load();
+    std::size_t const misses = misses_.load();
+    if(hits == 0 && misses == 0)
+        return;
+    report::format(level,
+        "Header registry: {} extracted, {} skipped ({:.1f}% hit rate)",
+        misses, hits, 100.0 * hits / (hits + misses));
+}
+
+} // mrdocs
+} // clang
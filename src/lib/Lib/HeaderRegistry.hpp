@@ -0,0 +1,85 @@
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+// Copyright (c) 2023 Vinnie Falco (vinnie.falco@gmail.com)
+//
+// Official repository: https://github.com/cppalliance/mrdocs
+//
+
+#ifndef MRDOCS_LIB_HEADERREGISTRY_HPP
+#define MRDOCS_LIB_HEADERREGISTRY_HPP
+
+#include <mrdocs/Support/Error.hpp>
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_set>
+
+namespace clang {
+namespace mrdocs {
+
+/** A registry of headers which have already been extracted.
+
+    A header included by many translation units is
+    traversed by each of them, and all but one of the
+    resulting Info are discarded as duplicates. Once a
+    translation unit which includes a header completes
+    without errors, the header is added to the registry,
+    and the translation units which start afterwards
+    skip the declarations in it.
+
+    A header is identified by its full path and a
+    fingerprint of the preprocessor state in effect
+    when it was first entered. Including the same
+    header with a different set of macros defined
+    produces a different key, and the header is
+    extracted again.
+*/
+class HeaderRegistry
+{
+    std::mutex mutex_;
+    std::unordered_set<std::string> extracted_;
+    std::atomic<std::size_t> hits_ = 0;
+    std::atomic<std::size_t> misses_ = 0;
+
+public:
+    /** Return true if a header was already extracted.
+
+        @param path The full path to the header.
+
+        @param fingerprint The preprocessor fingerprint.
+    */
+    bool
+    contains(
+        std::string_view path,
+        std::uint64_t fingerprint);
+
+    /** Add a header extracted by a translation unit.
+
+        This must only be called once the translation
+        unit completed without errors, as the other
+        translation units will skip the header.
+
+        @param path The full path to the header.
+
+        @param fingerprint The preprocessor fingerprint.
+    */
+    void
+    insert(
+        std::string_view path,
+        std::uint64_t fingerprint);
+
+    /** Report the number of hits and misses.
+    */
+    void
+    reportEnd(report::Level level) const;
+};
+
+} // mrdocs
+} // clang
+
+#endif
@@ -1,5 +1,8 @@
 
 #include "Info.hpp"
+#include <mrdocs/Metadata.hpp>
+#include <bit>
+#include <cstring>
 
 namespace clang {
 namespace mrdocs {
@@ -54,5 +57,108 @@ operator()(
     return b->id == a;
 }
 
+//------------------------------------------------
+
+namespace {
+
+std::size_t
+hashID(SymbolID const& id) noexcept
+{
+    // the IDs are SHA1 digests, so any
+    // bytes of them make a good hash
+    std::uint64_t hash;
+    std::memcpy(&hash, id.data(), sizeof(hash));
+    return static_cast<std::size_t>(hash);
+}
+
+} // (anon)
+
+InfoTable::
+~InfoTable()
+{
+    for(Info* I : infos_)
+        I->~Info();
+}
+
+std::size_t
+InfoTable::
+findSlot(SymbolID const& id) const noexcept
+{
+    MRDOCS_ASSERT(! slots_.empty());
+    std::size_t const mask = slots_.size() - 1;
+    std::size_t slot = hashID(id) & mask;
+    while(slots_[slot] != 0 &&
+        infos_[slots_[slot] - 1]->id != id)
+        slot = (slot + 1) & mask;
+    return slot;
+}
+
+void
+InfoTable::
+grow(std::size_t capacity)
+{
+    std::size_t const size = std::bit_ceil(
+        std::max<std::size_t>(capacity * 2, 16));
+    if(size <= slots_.size())
+        return;
+    slots_.assign(size, 0);
+    for(std::size_t i = 0; i < infos_.size(); ++i)
+        slots_[findSlot(infos_[i]->id)] =
+            static_cast<std::uint32_t>(i + 1);
+}
+
+Info*
+InfoTable::
+insert(std::unique_ptr<Info> I)
+{
+    MRDOCS_ASSERT(I);
+    grow(infos_.size() + 1);
+    std::size_t const slot = findSlot(I->id);
+    if(slots_[slot] != 0)
+        return infos_[slots_[slot] - 1];
+
+    Info* result = visit(*I, [&]<class T>(T& t) -> Info*
+    {
+        return new(arena_.Allocate<T>()) T(std::move(t));
+    });
+    infos_.push_back(result);
+    slots_[slot] = static_cast<std::uint32_t>(infos_.size());
+    return result;
+}
+
+void
+InfoTable::
+insert(InfoSet&& infos)
+{
+    grow(infos_.size() + infos.size());
+    infos_.reserve(infos_.size() + infos.size());
+    while(! infos.empty())
+        insert(std::move(infos.extract(infos.begin()).value()));
+}
+
+Info*
+InfoTable::
+find(SymbolID const& id) const noexcept
+{
+    if(slots_.empty())
+        return nullptr;
+    std::size_t const slot = findSlot(id);
+    if(slots_[slot] == 0)
+        return nullptr;
+    return infos_[slots_[slot] - 1];
+}
+
+Info*
+InfoTable::
+next(Info const& I) const noexcept
+{
+    std::size_t const slot = findSlot(I.id);
+    MRDOCS_ASSERT(slots_[slot] != 0);
+    std::size_t const pos = slots_[slot];
+    if(pos == infos_.size())
+        return nullptr;
+    return infos_[pos];
+}
+
 } // mrdocs
 } // clang
@@ -15,8 +15,11 @@
 
 #include <mrdocs/Platform.hpp>
 #include <mrdocs/Metadata/Info.hpp>
+#include <llvm/Support/Allocator.h>
+#include <cstdint>
 #include <memory>
 #include <unordered_set>
+#include <vector>
 
 namespace clang {
 namespace mrdocs {
@@ -52,6 +55,106 @@ struct InfoPtrEqual
 using InfoSet = std::unordered_set<
     std::unique_ptr<Info>, InfoPtrHasher, InfoPtrEqual>;
 
+/** The symbols of a corpus.
+
+    The Info objects are moved into an arena owned
+    by the table, and listed in a dense vector in
+    the order they were inserted. They are found
+    by an open addressing index which uses the
+    bytes of the SymbolID as the hash, since the
+    IDs are already uniformly distributed.
+
+    The objects never move once inserted, so the
+    pointers to them remain valid for the lifetime
+    of the table.
+*/
+class InfoTable
+{
+    llvm::BumpPtrAllocator arena_;
+    std::vector<Info*> infos_;
+
+    // the position in infos_ plus one, or zero
+    // for an empty slot. the number of slots is
+    // a power of two and at least twice the
+    // number of symbols
+    std::vector<std::uint32_t> slots_;
+
+    std::size_t
+    findSlot(SymbolID const& id) const noexcept;
+
+    void
+    grow(std::size_t capacity);
+
+public:
+    using iterator = std::vector<Info*>::const_iterator;
+
+    InfoTable() = default;
+    InfoTable(InfoTable const&) = delete;
+    InfoTable& operator=(InfoTable const&) = delete;
+
+    /** Destructor.
+
+        The destructor of every Info is called
+        before the memory of the arena is released.
+    */
+    ~InfoTable();
+
+    /** Move an Info into the table.
+
+        If the table already holds an Info with
+        the same ID, the table is unchanged.
+
+        @return The Info in the table.
+    */
+    Info*
+    insert(std::unique_ptr<Info> I);
+
+    /** Move the results of extraction into the table.
+    */
+    void
+    insert(InfoSet&& infos);
+
+    /** Return the Info with the specified ID, or nullptr.
+    */
+    Info*
+    find(SymbolID const& id) const noexcept;
+
+    /** Return the Info following another in the iteration order, or nullptr.
+    */
+    Info*
+    next(Info const& I) const noexcept;
+
+    bool
+    contains(SymbolID const& id) const noexcept
+    {
+        return find(id) != nullptr;
+    }
+
+    std::size_t
+    size() const noexcept
+    {
+        return infos_.size();
+    }
+
+    bool
+    empty() const noexcept
+    {
+        return infos_.empty();
+    }
+
+    iterator
+    begin() const noexcept
+    {
+        return infos_.begin();
+    }
+
+    iterator
+    end() const noexcept
+    {
+        return infos_.end();
+    }
+};
+
 } // mrdocs
 } // clang
 
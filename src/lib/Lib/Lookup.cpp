@@ -10,6 +10,7 @@
 
 #include "Lookup.hpp"
 #include <mrdocs/Metadata.hpp>
+#include <algorithm>
 
 namespace clang {
 namespace mrdocs {
@@ -80,18 +81,48 @@ LookupTable(
     MRDOCS_ASSERT(supportsLookup(&info));
 
     buildLookups(corpus, info, *this);
+    lookups_.shrink_to_fit();
+    std::stable_sort(lookups_.begin(), lookups_.end(),
+        [](const auto& a, const auto& b)
+        {
+            return a.first < b.first;
+        });
 }
 
 SymbolLookup::
 SymbolLookup(const Corpus& corpus)
     : corpus_(corpus)
 {
-    for(const Info& I : corpus_)
+}
+
+mrdocs::Expected<std::unique_ptr<SymbolLookup>>
+SymbolLookup::
+build(
+    const Corpus& corpus,
+    ThreadPool& threadPool)
+{
+    std::unique_ptr<SymbolLookup> result(
+        new SymbolLookup(corpus));
+
+    // every table is created first, so that
+    // the map is not modified while the
+    // tables are built by other threads
+    std::vector<std::pair<const Info*, LookupTable*>> tables;
+    for(const Info& I : corpus)
     {
         if(! supportsLookup(&I))
             continue;
-        lookup_tables_.emplace(&I, LookupTable(I, corpus_));
+        tables.emplace_back(&I, &result->lookup_tables_[&I]);
     }
+
+    auto errors = threadPool.forEach(tables,
+        [&](std::pair<const Info*, LookupTable*> const& table)
+        {
+            *table.second = LookupTable(*table.first, corpus);
+        });
+    if(! errors.empty())
+        return Unexpected(Error(errors));
+    return result;
 }
 
 const Info*
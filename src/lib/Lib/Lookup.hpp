@@ -14,12 +14,17 @@
 #include <mrdocs/Platform.hpp>
 #include <mrdocs/Corpus.hpp>
 #include <mrdocs/Metadata/Symbols.hpp>
+#include <mrdocs/Support/Error.hpp>
+#include <mrdocs/Support/ThreadPool.hpp>
+#include <algorithm>
 #include <memory>
 #include <span>
 #include <string>
 #include <string_view>
 #include <ranges>
 #include <unordered_map>
+#include <utility>
+#include <vector>
 
 namespace clang {
 namespace mrdocs {
@@ -29,25 +34,47 @@ class LookupTable
     // maps unquaified names to symbols with that name.
     // names from member symbols which are "transparent"
     // (e.g. unscoped enums and inline namespaces) will
-    // have their members added to the table as well
-    std::unordered_multimap<
-        std::string_view, const Info*> lookups_;
+    // have their members added to the table as well.
+    // the entries are sorted by name, and symbols with
+    // the same name are kept in the order they were added
+    std::vector<std::pair<
+        std::string_view, const Info*>> lookups_;
+
+    struct NameLess
+    {
+        bool operator()(
+            const std::pair<std::string_view, const Info*>& entry,
+            std::string_view name) const noexcept
+        {
+            return entry.first < name;
+        }
+
+        bool operator()(
+            std::string_view name,
+            const std::pair<std::string_view, const Info*>& entry) const noexcept
+        {
+            return name < entry.first;
+        }
+    };
 
 public:
+    LookupTable() = default;
+
     LookupTable(
         const Info& info,
         const Corpus& corpus);
 
     auto lookup(std::string_view name) const
     {
-        auto [first, last] = lookups_.equal_range(name);
+        auto [first, last] = std::equal_range(
+            lookups_.begin(), lookups_.end(), name, NameLess());
         return std::ranges::subrange(
             first, last) | std::views::values;
     }
 
     void add(std::string_view name, const Info* info)
     {
-        lookups_.emplace(name, info);
+        lookups_.emplace_back(name, info);
     }
 };
 
@@ -68,9 +95,6 @@ class SymbolLookup
     template<typename Fn>
     auto makeHandler(Fn& fn);
 
-    const Info*
-    adjustLookupContext(const Info* context);
-
     const Info*
     lookThroughTypedefs(const Info* I);
 
@@ -99,9 +123,31 @@ class SymbolLookup
         std::string_view terminal,
         LookupCallback& callback);
 
-public:
+    explicit
     SymbolLookup(const Corpus& corpus);
 
+public:
+    /** Return the lookup tables for a corpus.
+
+        The lookup tables of the scopes are
+        built concurrently on the thread pool.
+    */
+    [[nodiscard]]
+    static
+    mrdocs::Expected<std::unique_ptr<SymbolLookup>>
+    build(
+        const Corpus& corpus,
+        ThreadPool& threadPool);
+
+    /** Return the innermost context of a symbol which supports lookup.
+
+        Unqualified lookup from a symbol starts in this
+        context, so lookups of the same name from symbols
+        with the same context have the same results.
+    */
+    const Info*
+    adjustLookupContext(const Info* context);
+
     template<typename Fn>
     const Info*
     lookupUnqualified(
@@ -0,0 +1,291 @@
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+// Copyright (c) 2023 Vinnie Falco (vinnie.falco@gmail.com)
+//
+// Official repository: https://github.com/cppalliance/mrdocs
+//
+
+#include "PageManifest.hpp"
+#include "lib/Support/BinaryIO.hpp"
+#include <mrdocs/Support/Path.hpp>
+#include <mrdocs/Version.hpp>
+#include <llvm/ADT/StringExtras.h>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/MemoryBuffer.h>
+#include <llvm/Support/raw_ostream.h>
+#include <llvm/Support/xxhash.h>
+#include <algorithm>
+
+namespace clang {
+namespace mrdocs {
+
+namespace {
+
+// identifies a manifest file, and the
+// version of the layout which follows
+constexpr llvm::StringLiteral manifestMagic = "MRDOCSPM";
+constexpr std::uint32_t manifestVersion = 1;
+
+/** Return a hash of everything besides the symbols which affects the pages.
+*/
+std::uint64_t
+hashEnvironment(
+    std::string_view templatesDir,
+    Config const& config)
+{
+    std::string data;
+    auto const update = [&](llvm::StringRef str)
+    {
+        data.append(str.data(), str.size());
+        // separate the fields so that
+        // adjacent strings cannot collide
+        data.push_back('\0');
+    };
+    update(project_version);
+    update(config->configYaml);
+    update(config->extraYaml);
+    update(templatesDir);
+
+    // visit the templates in a stable order
+    std::vector<std::string> paths;
+    auto err = forEachFile(templatesDir, true,
+        [&](std::string_view path) -> Error
+        {
+            paths.emplace_back(path);
+            return Error::success();
+        });
+    if(err)
+        report::warn("Warning: failed to list the templates: {}", err);
+    std::sort(paths.begin(), paths.end());
+    for(auto const& path : paths)
+    {
+        update(path);
+        if(auto text = files::getFileText(path))
+            update(*text);
+    }
+    return llvm::xxh3_64bits(
+        llvm::arrayRefFromStringRef(data));
+}
+
+} // (anon)
+
+PageManifest::
+PageManifest(
+    std::string_view outputPath,
+    std::string_view templatesDir,
+    Corpus const& corpus,
+    std::shared_ptr<SymbolHashes const> hashes)
+    : outputPath_(outputPath)
+    , environment_(hashEnvironment(templatesDir, corpus.config))
+    , hashes_(std::move(hashes))
+{
+    load();
+}
+
+void
+PageManifest::
+load()
+{
+    auto buffer = llvm::MemoryBuffer::getFile(
+        manifestPath(), false, false);
+    if(! buffer)
+        return;
+
+    BinaryReader reader((*buffer)->getBuffer());
+    llvm::StringRef magic;
+    std::uint64_t version;
+    std::uint64_t environment;
+    if(! reader.readBytes(manifestMagic.size(), magic) ||
+        magic != manifestMagic ||
+        ! reader.readInt(version) ||
+        version != manifestVersion ||
+        ! reader.readInt(environment) ||
+        environment != environment_)
+        return;
+
+    // the symbols referenced by the pages,
+    // and whether each is unchanged
+    std::uint64_t count;
+    if(! reader.readInt(count))
+        return;
+    std::vector<SymbolID> symbols;
+    std::vector<bool> unchanged;
+    symbols.reserve(count);
+    unchanged.reserve(count);
+    while(count--)
+    {
+        llvm::StringRef id;
+        std::uint64_t hash;
+        if(! reader.readBytes(SymbolID().size(), id) ||
+            ! reader.readInt(hash))
+            return;
+        SymbolID const& symbol = symbols.emplace_back(
+            reinterpret_cast<const std::uint8_t*>(id.data()));
+        auto it = hashes_->find(symbol);
+        unchanged.push_back(
+            it != hashes_->end() && it->second == hash);
+    }
+
+    if(! reader.readInt(count))
+        return;
+    llvm::StringMap<std::vector<SymbolID>> pages;
+    while(count--)
+    {
+        llvm::StringRef fileName;
+        std::uint64_t size;
+        if(! reader.readString(fileName) ||
+            ! reader.readInt(size))
+            return;
+        std::vector<SymbolID> ids;
+        ids.reserve(size);
+        bool valid = true;
+        while(size--)
+        {
+            std::uint64_t index;
+            if(! reader.readInt(index) ||
+                index >= symbols.size())
+                return;
+            valid = valid && unchanged[index];
+            ids.push_back(symbols[index]);
+        }
+        if(valid)
+            pages[fileName] = std::move(ids);
+    }
+    current_ = std::move(pages);
+}
+
+bool
+PageManifest::
+upToDate(std::string_view fileName)
+{
+    auto it = current_.find(fileName);
+    if(it == current_.end() ||
+        ! llvm::sys::fs::exists(
+            files::appendPath(outputPath_, fileName)))
+        return false;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        pages_[fileName] = it->second;
+    }
+    ++skipped_;
+    return true;
+}
+
+void
+PageManifest::
+record(
+    std::string_view fileName,
+    std::unordered_set<SymbolID> const& ids)
+{
+    std::vector<SymbolID> list(ids.begin(), ids.end());
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        pages_[fileName] = std::move(list);
+    }
+    ++rendered_;
+}
+
+void
+PageManifest::
+save() const
+{
+    std::string const path = manifestPath();
+
+    // write to a temporary file first so that concurrent
+    // runs never observe a partially written manifest
+    int fd;
+    llvm::SmallString<128> temp_path;
+    if(auto ec = llvm::sys::fs::createUniqueFile(
+        path + ".%%%%%%%%.tmp", fd, temp_path))
+    {
+        report::warn("Warning: failed to write \"{}\": {}", path, ec);
+        return;
+    }
+
+    {
+        llvm::raw_fd_ostream os(fd, true);
+        std::lock_guard<std::mutex> lock(mutex_);
+
+        // the pages which this run did not visit keep
+        // the dependencies recorded by the last run,
+        // unless they changed or the page was removed
+        llvm::StringMap<std::vector<SymbolID>> pages(pages_);
+        for(auto const& page : current_)
+        {
+            if(! pages.contains(page.getKey()) &&
+                llvm::sys::fs::exists(files::appendPath(
+                    outputPath_, page.getKey())))
+                pages.try_emplace(page.getKey(), page.getValue());
+        }
+
+        // each symbol is written once, and
+        // the pages refer to it by index
+        std::vector<SymbolID> symbols;
+        std::unordered_map<SymbolID, std::uint64_t> indices;
+        for(auto const& page : pages)
+        {
+            for(SymbolID const& id : page.getValue())
+            {
+                if(indices.try_emplace(id, symbols.size()).second)
+                    symbols.push_back(id);
+            }
+        }
+
+        os << manifestMagic;
+        writeInt(os, manifestVersion);
+        writeInt(os, environment_);
+        writeInt(os, symbols.size());
+        for(SymbolID const& id : symbols)
+        {
+            auto it = hashes_->find(id);
+            os << std::string_view(id);
+            writeInt(os, it != hashes_->end() ? it->second : 0);
+        }
+        writeInt(os, pages.size());
+        for(auto const& page : pages)
+        {
+            writeString(os, page.getKey());
+            writeInt(os, page.getValue().size());
+            for(SymbolID const& id : page.getValue())
+                writeInt(os, indices.at(id));
+        }
+        os.close();
+        if(os.has_error())
+        {
+            report::warn("Warning: failed to write \"{}\": {}",
+                path, os.error());
+            os.clear_error();
+            llvm::sys::fs::remove(temp_path);
+            return;
+        }
+    }
+
+    if(auto ec = llvm::sys::fs::rename(temp_path, path))
+    {
+        report::warn("Warning: failed to write \"{}\": {}", path, ec);
+        llvm::sys::fs::remove(temp_path);
+    }
+}
+
+void
+PageManifest::
+reportEnd(report::Level level) const
+{
+    report::format(level,
+        "Pages: {} rendered, {} up to date",
+        rendered_.load(), skipped_.load());
+}
+
+std::string
+PageManifest::
+manifestPath() const
+{
+    return files::appendPath(
+        outputPath_, ".mrdocs-pages");
+}
+
+} // mrdocs
+} // clang
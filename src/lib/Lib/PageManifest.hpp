@@ -0,0 +1,128 @@
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+// Copyright (c) 2023 Vinnie Falco (vinnie.falco@gmail.com)
+//
+// Official repository: https://github.com/cppalliance/mrdocs
+//
+
+#ifndef MRDOCS_LIB_PAGEMANIFEST_HPP
+#define MRDOCS_LIB_PAGEMANIFEST_HPP
+
+#include "lib/Lib/CorpusDiff.hpp"
+#include <mrdocs/Platform.hpp>
+#include <mrdocs/Corpus.hpp>
+#include <mrdocs/Support/Error.hpp>
+#include <llvm/ADT/StringMap.h>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace clang {
+namespace mrdocs {
+
+/** The symbols each page of a multi-page output depends on.
+
+    The manifest is stored in the output directory.
+    For each page written by the last run, it holds
+    the symbols accessed while rendering the page,
+    together with a hash of their content. A page is
+    rendered again only if one of these symbols
+    changed, or if the templates, the configuration
+    or the version of MrDocs changed.
+*/
+class PageManifest
+{
+public:
+    /** Constructor.
+
+        The manifest written by the last run is
+        loaded from the output directory, if any.
+
+        @param outputPath The output directory.
+
+        @param templatesDir The directory holding
+        the templates and helpers of the generator.
+
+        @param corpus The symbols to emit.
+
+        @param hashes The hashes of the symbols
+        of the corpus, as returned by @ref hashSymbols.
+    */
+    PageManifest(
+        std::string_view outputPath,
+        std::string_view templatesDir,
+        Corpus const& corpus,
+        std::shared_ptr<SymbolHashes const> hashes);
+
+    /** Return true if a page does not need to be rendered.
+
+        The dependencies of a page which is up to
+        date are kept for the next run.
+
+        This function is thread-safe.
+
+        @param fileName The path of the page,
+        relative to the output directory.
+    */
+    bool
+    upToDate(std::string_view fileName);
+
+    /** Record the dependencies of a rendered page.
+
+        This function is thread-safe.
+
+        @param fileName The path of the page,
+        relative to the output directory.
+
+        @param ids The symbols accessed while
+        rendering the page.
+    */
+    void
+    record(
+        std::string_view fileName,
+        std::unordered_set<SymbolID> const& ids);
+
+    /** Write the manifest to the output directory.
+
+        The pages of the last run which were neither
+        rendered nor checked by this run, such as the
+        pages skipped by an incremental build, are
+        kept if they are still up to date.
+    */
+    void
+    save() const;
+
+    void
+    reportEnd(report::Level level) const;
+
+private:
+    std::string manifestPath() const;
+
+    void load();
+
+    std::string outputPath_;
+    std::uint64_t environment_ = 0;
+    std::shared_ptr<SymbolHashes const> hashes_;
+
+    // the pages of the last run which are up to date
+    llvm::StringMap<std::vector<SymbolID>> current_;
+
+    mutable std::mutex mutex_;
+    llvm::StringMap<std::vector<SymbolID>> pages_;
+    std::atomic<std::size_t> skipped_ = 0;
+    std::atomic<std::size_t> rendered_ = 0;
+};
+
+} // mrdocs
+} // clang
+
+#endif
@@ -0,0 +1,306 @@
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+// Copyright (c) 2023 Vinnie Falco (vinnie.falco@gmail.com)
+//
+// Official repository: https://github.com/cppalliance/mrdocs
+//
+
+#include "SharedPreambles.hpp"
+#include "lib/Lib/CompileGroups.hpp"
+#include <mrdocs/Support/Path.hpp>
+#include <mrdocs/Support/ThreadPool.hpp>
+#include <clang/Basic/Diagnostic.h>
+#include <clang/Frontend/CompilerInstance.h>
+#include <clang/Frontend/FrontendActions.h>
+#include <clang/Lex/Preprocessor.h>
+#include <clang/Tooling/Tooling.h>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/MemoryBuffer.h>
+#include <llvm/Support/VirtualFileSystem.h>
+#include <llvm/Support/raw_ostream.h>
+#include <algorithm>
+
+namespace clang {
+namespace mrdocs {
+
+namespace {
+
+/** Return the `#include <...>` directives at the start of a file.
+
+    Blank lines, comments, and `#pragma once` are
+    skipped. The scan stops at the first line which
+    is anything else, including a quoted include,
+    since those are resolved relative to the file.
+*/
+std::vector<std::string>
+getLeadingIncludes(llvm::StringRef text)
+{
+    std::vector<std::string> includes;
+    bool in_comment = false;
+    while(! text.empty())
+    {
+        llvm::StringRef line;
+        std::tie(line, text) = text.split('\n');
+        line = line.trim();
+        if(in_comment)
+        {
+            auto end = line.find("*/");
+            if(end == llvm::StringRef::npos)
+                continue;
+            in_comment = false;
+            line = line.drop_front(end + 2).ltrim();
+        }
+        if(line.starts_with("/*"))
+        {
+            auto end = line.find("*/", 2);
+            if(end == llvm::StringRef::npos)
+            {
+                in_comment = true;
+                continue;
+            }
+            line = line.drop_front(end + 2).ltrim();
+        }
+        if(line.empty() || line.starts_with("//"))
+            continue;
+        if(! line.consume_front("#"))
+            break;
+        line = line.ltrim();
+        if(line.starts_with("pragma once"))
+            continue;
+        if(! line.consume_front("include"))
+            break;
+        line = line.ltrim();
+        auto end = line.find('>');
+        if(! line.starts_with("<") ||
+            end == llvm::StringRef::npos)
+            break;
+        includes.emplace_back(line.take_front(end + 1));
+    }
+    return includes;
+}
+
+/** Generates a precompiled header, recording the files it reads.
+*/
+class PreambleAction
+    : public GeneratePCHAction
+{
+    std::vector<ExtractionCache::Dependency>& dependencies_;
+
+public:
+    explicit
+    PreambleAction(
+        std::vector<ExtractionCache::Dependency>& dependencies)
+        : dependencies_(dependencies)
+    {
+    }
+
+    bool
+    BeginSourceFileAction(
+        CompilerInstance& CI) override
+    {
+        CI.getPreprocessor().addPPCallbacks(
+            std::make_unique<IncludeHasher>(
+                CI.getSourceManager(), dependencies_));
+        return GeneratePCHAction::BeginSourceFileAction(CI);
+    }
+};
+
+} // (anon)
+
+SharedPreambles::
+SharedPreambles(
+    ConfigImpl const& config,
+    tooling::CompilationDatabase const& compilations)
+    : config_(config)
+    , compilations_(compilations)
+{
+    llvm::SmallString<128> temp_dir;
+    if(auto ec = llvm::sys::fs::createUniqueDirectory(
+        "mrdocs-preambles", temp_dir))
+    {
+        report::warn("Warning: failed to create a directory "
+            "for shared preambles: {}", ec);
+        return;
+    }
+    tempDir_ = temp_dir.str();
+}
+
+SharedPreambles::
+~SharedPreambles()
+{
+    if(! tempDir_.empty())
+        llvm::sys::fs::remove_directories(tempDir_);
+}
+
+void
+SharedPreambles::
+build(std::vector<std::string> const& files)
+{
+    if(tempDir_.empty())
+        return;
+
+    auto const start_time = std::chrono::steady_clock::now();
+
+    // determine the preamble shared by each group
+    std::vector<CompileGroup> groups =
+        groupCompileCommands(compilations_, files);
+    std::vector<std::pair<CompileGroup const*,
+        std::vector<std::string>>> jobs;
+    for(auto const& group : groups)
+    {
+        // a preamble used by a single file is never reused
+        if(group.files.size() < 2)
+            continue;
+        std::vector<std::string> common;
+        for(std::size_t i = 0; i < group.files.size(); ++i)
+        {
+            auto buffer = llvm::MemoryBuffer::getFile(group.files[i]);
+            if(! buffer)
+            {
+                common.clear();
+                break;
+            }
+            auto includes = getLeadingIncludes(
+                (*buffer)->getBuffer());
+            if(i == 0)
+            {
+                common = std::move(includes);
+                continue;
+            }
+            auto mismatch = std::mismatch(
+                common.begin(), common.end(),
+                includes.begin(), includes.end());
+            common.erase(mismatch.first, common.end());
+            if(common.empty())
+                break;
+        }
+        if(common.empty())
+            continue;
+        for(auto const& file : group.files)
+            index_.emplace(file, jobs.size());
+        jobs.emplace_back(&group, std::move(common));
+    }
+    preambles_.resize(jobs.size());
+
+    TaskGroup taskGroup(config_.threadPool());
+    for(std::size_t i = 0; i < jobs.size(); ++i)
+    {
+        taskGroup.async(
+        [&, i]()
+        {
+            auto const& [group, includes] = jobs[i];
+            Preamble& preamble = preambles_[i];
+
+            // write the header containing the preamble
+            std::string header_path = files::appendPath(
+                tempDir_, fmt::format("preamble-{}.h", i));
+            {
+                std::error_code ec;
+                llvm::raw_fd_ostream os(header_path, ec);
+                if(ec)
+                {
+                    report::warn("Warning: failed to write "
+                        "\"{}\": {}", header_path, ec);
+                    return;
+                }
+                for(auto const& include : includes)
+                    os << "#include " << include << '\n';
+            }
+
+            std::string pch_path = files::appendPath(
+                tempDir_, fmt::format("preamble-{}.pch", i));
+            std::vector<std::string> args = group->arguments;
+            args.insert(args.end(), {
+                // comments must be retained as they are
+                // when the translation units are parsed
+                "-fretain-comments-from-system-headers",
+                "-x", "c++-header", header_path,
+                "-o", pch_path });
+
+            IntrusiveRefCntPtr<llvm::vfs::FileSystem> FS =
+                llvm::vfs::createPhysicalFileSystem();
+            FS->setCurrentWorkingDirectory(group->command.Directory);
+            IntrusiveRefCntPtr<FileManager> FM(
+                new FileManager(FileSystemOptions(), FS));
+
+            tooling::ToolInvocation invocation(
+                std::move(args),
+                std::make_unique<PreambleAction>(
+                    preamble.dependencies),
+                FM.get(),
+                std::make_shared<PCHContainerOperations>());
+            IgnoringDiagConsumer diags;
+            invocation.setDiagnosticConsumer(&diags);
+            if(! invocation.run())
+            {
+                report::warn("Warning: failed to build the "
+                    "shared preamble for \"{}\"",
+                    group->files.front());
+                return;
+            }
+            preamble.pchPath = std::move(pch_path);
+        });
+    }
+    taskGroup.wait();
+
+    buildTime_ = std::chrono::steady_clock::now() - start_time;
+}
+
+auto
+SharedPreambles::
+find(std::string_view path) ->
+    Preamble const*
+{
+    auto it = index_.find(std::string(path));
+    if(it == index_.end())
+        return nullptr;
+    Preamble const& preamble = preambles_[it->second];
+    if(preamble.pchPath.empty())
+        return nullptr;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if(unusable_.contains(&preamble))
+            return nullptr;
+    }
+    ++reuses_;
+    return &preamble;
+}
+
+void
+SharedPreambles::
+markUnusable(
+    Preamble const& preamble,
+    std::string_view path)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if(! unusable_.insert(&preamble).second)
+            return;
+    }
+    report::warn(
+        "Warning: the shared preamble \"{}\" could not be loaded by "
+        "\"{}\", the files of its group are parsed without it",
+        preamble.pchPath, path);
+}
+
+void
+SharedPreambles::
+reportEnd(report::Level level) const
+{
+    if(preambles_.empty())
+        return;
+    std::size_t built = 0;
+    for(auto const& preamble : preambles_)
+        built += ! preamble.pchPath.empty();
+    auto const build_ms = std::chrono::duration_cast<
+        std::chrono::milliseconds>(buildTime_).count();
+    report::format(level,
+        "Built {} shared preambles in {} ms, used by {} translation units",
+        built, build_ms, reuses_.load());
+}
+
+} // mrdocs
+} // clang
@@ -0,0 +1,112 @@
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+// Copyright (c) 2023 Vinnie Falco (vinnie.falco@gmail.com)
+//
+// Official repository: https://github.com/cppalliance/mrdocs
+//
+
+#ifndef MRDOCS_LIB_SHAREDPREAMBLES_HPP
+#define MRDOCS_LIB_SHAREDPREAMBLES_HPP
+
+#include "lib/Lib/ConfigImpl.hpp"
+#include "lib/Lib/ExtractionCache.hpp"
+#include <mrdocs/Support/Error.hpp>
+#include <clang/Tooling/CompilationDatabase.h>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace clang {
+namespace mrdocs {
+
+/** Precompiled preambles shared by translation units with equivalent flags.
+
+    Translation units are grouped by their compile
+    commands. For each group, the `#include <...>`
+    directives which appear at the start of every
+    file in the group form a preamble, which is
+    precompiled once and then loaded by each
+    translation unit in the group with `-include-pch`.
+
+    The precompiled headers are written to a
+    temporary directory which is removed when
+    this object is destroyed.
+*/
+class SharedPreambles
+{
+public:
+    /** A precompiled preamble.
+    */
+    struct Preamble
+    {
+        /** The path to the precompiled header.
+        */
+        std::string pchPath;
+
+        /** The files read when building the preamble.
+        */
+        std::vector<ExtractionCache::Dependency> dependencies;
+    };
+
+    SharedPreambles(
+        ConfigImpl const& config,
+        tooling::CompilationDatabase const& compilations);
+
+    ~SharedPreambles();
+
+    /** Build the preamble for each group of files.
+
+        The preambles are built on the thread pool.
+        A group whose preamble fails to build is
+        parsed without one.
+    */
+    void
+    build(std::vector<std::string> const& files);
+
+    /** Return the preamble for a file, or nullptr if there is none.
+    */
+    Preamble const*
+    find(std::string_view path);
+
+    /** Stop using a preamble which failed to load.
+
+        The files of its group are parsed without
+        a preamble from then on.
+
+        @param preamble The preamble returned by @ref find.
+        @param path The file which failed to load it.
+    */
+    void
+    markUnusable(
+        Preamble const& preamble,
+        std::string_view path);
+
+    /** Report the build time and the number of reuses.
+    */
+    void
+    reportEnd(report::Level level) const;
+
+private:
+    ConfigImpl const& config_;
+    tooling::CompilationDatabase const& compilations_;
+    std::string tempDir_;
+    std::vector<Preamble> preambles_;
+    std::unordered_map<std::string, std::size_t> index_;
+    std::mutex mutex_;
+    std::unordered_set<Preamble const*> unusable_;
+    std::chrono::steady_clock::duration buildTime_{};
+    std::atomic<std::size_t> reuses_ = 0;
+};
+
+} // mrdocs
+} // clang
+
+#endif
@@ -0,0 +1,114 @@
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+// Copyright (c) 2023 Vinnie Falco (vinnie.falco@gmail.com)
+//
+// Official repository: https://github.com/cppalliance/mrdocs
+//
+
+#include "UnityBatches.hpp"
+#include "lib/Lib/CompileGroups.hpp"
+#include <mrdocs/Support/Path.hpp>
+#include <fmt/format.h>
+#include <algorithm>
+#include <unordered_set>
+
+namespace clang {
+namespace mrdocs {
+
+UnityBatch::
+UnityBatch(
+    tooling::CompileCommand command,
+    std::vector<std::string> files)
+    : command_(std::move(command))
+    , files_(std::move(files))
+{
+    for(auto const& file : files_)
+    {
+        contents_ += fmt::format("#include \"{}\"\n",
+            files::makePosixStyle(file));
+    }
+}
+
+std::vector<tooling::CompileCommand>
+UnityBatch::
+getCompileCommands(
+    llvm::StringRef FilePath) const
+{
+    if(! FilePath.equals(command_.Filename))
+        return {};
+    return { command_ };
+}
+
+std::vector<std::string>
+UnityBatch::
+getAllFiles() const
+{
+    return { command_.Filename };
+}
+
+std::vector<tooling::CompileCommand>
+UnityBatch::
+getAllCompileCommands() const
+{
+    return { command_ };
+}
+
+//------------------------------------------------
+
+std::vector<UnityBatch>
+makeUnityBatches(
+    tooling::CompilationDatabase const& compilations,
+    std::vector<std::string>& files,
+    std::size_t batchSize)
+{
+    std::vector<UnityBatch> batches;
+    if(batchSize < 2)
+        return batches;
+
+    std::unordered_set<std::string> batched;
+    for(auto& group : groupCompileCommands(compilations, files))
+    {
+        if(group.files.size() < 2)
+            continue;
+        for(std::size_t first = 0;
+            first < group.files.size(); first += batchSize)
+        {
+            std::size_t const last = std::min(
+                first + batchSize, group.files.size());
+            // a batch of one file gains nothing
+            if(last - first < 2)
+                break;
+
+            std::string path = files::appendPath(
+                group.command.Directory,
+                fmt::format("mrdocs-unity-{}.cpp", batches.size()));
+            std::vector<std::string> args = group.arguments;
+            args.push_back(path);
+            std::vector<std::string> batch_files(
+                group.files.begin() + first,
+                group.files.begin() + last);
+            batched.insert(batch_files.begin(), batch_files.end());
+
+            batches.emplace_back(
+                tooling::CompileCommand(
+                    group.command.Directory,
+                    path,
+                    std::move(args),
+                    ""),
+                std::move(batch_files));
+        }
+    }
+
+    std::erase_if(files,
+        [&](std::string const& file)
+        {
+            return batched.contains(file);
+        });
+    return batches;
+}
+
+} // mrdocs
+} // clang
@@ -0,0 +1,101 @@
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+// Copyright (c) 2023 Vinnie Falco (vinnie.falco@gmail.com)
+//
+// Official repository: https://github.com/cppalliance/mrdocs
+//
+
+#ifndef MRDOCS_LIB_UNITYBATCHES_HPP
+#define MRDOCS_LIB_UNITYBATCHES_HPP
+
+#include <mrdocs/Platform.hpp>
+#include <clang/Tooling/CompilationDatabase.h>
+#include <string>
+#include <vector>
+
+namespace clang {
+namespace mrdocs {
+
+/** A synthetic translation unit which includes several source files.
+
+    The main file of the batch does not exist on
+    disk. It is mapped into the virtual file system
+    of the tool, and consists of one `#include`
+    directive per file in the batch. Declarations
+    are therefore still located in the original
+    files.
+*/
+class UnityBatch
+    : public tooling::CompilationDatabase
+{
+    tooling::CompileCommand command_;
+    std::string contents_;
+    std::vector<std::string> files_;
+
+public:
+    UnityBatch(
+        tooling::CompileCommand command,
+        std::vector<std::string> files);
+
+    /** Return the path of the synthetic main file.
+    */
+    std::string const&
+    path() const noexcept
+    {
+        return command_.Filename;
+    }
+
+    /** Return the contents of the synthetic main file.
+    */
+    std::string const&
+    contents() const noexcept
+    {
+        return contents_;
+    }
+
+    /** Return the files included by the batch.
+    */
+    std::vector<std::string> const&
+    files() const noexcept
+    {
+        return files_;
+    }
+
+    std::vector<tooling::CompileCommand>
+    getCompileCommands(
+        llvm::StringRef FilePath) const override;
+
+    std::vector<std::string>
+    getAllFiles() const override;
+
+    std::vector<tooling::CompileCommand>
+    getAllCompileCommands() const override;
+};
+
+/** Group files with equivalent compile commands into unity batches.
+
+    Files which share their compile command with at
+    least one other file are combined into batches
+    of at most `batchSize` files, and removed from
+    `files`. The remaining files are left in place.
+
+    @param compilations The compilation database.
+
+    @param files The files to process.
+
+    @param batchSize The maximum number of
+    files in a batch.
+*/
+std::vector<UnityBatch>
+makeUnityBatches(
+    tooling::CompilationDatabase const& compilations,
+    std::vector<std::string>& files,
+    std::size_t batchSize);
+
+} // mrdocs
+} // clang
+
+#endif
@@ -0,0 +1,43 @@
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+// Copyright (c) 2023 Vinnie Falco (vinnie.falco@gmail.com)
+//
+// Official repository: https://github.com/cppalliance/mrdocs
+//
+
+#include "lib/Metadata/DomDependencies.hpp"
+
+namespace clang {
+namespace mrdocs {
+
+namespace {
+
+thread_local DomDependencies* current_ = nullptr;
+
+} // (anon)
+
+DomDependencies::
+DomDependencies() noexcept
+    : prev_(current_)
+{
+    current_ = this;
+}
+
+DomDependencies::
+~DomDependencies()
+{
+    current_ = prev_;
+}
+
+DomDependencies*
+DomDependencies::
+current() noexcept
+{
+    return current_;
+}
+
+} // mrdocs
+} // clang
@@ -0,0 +1,92 @@
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+// Copyright (c) 2023 Vinnie Falco (vinnie.falco@gmail.com)
+//
+// Official repository: https://github.com/cppalliance/mrdocs
+//
+
+#ifndef MRDOCS_LIB_METADATA_DOMDEPENDENCIES_HPP
+#define MRDOCS_LIB_METADATA_DOMDEPENDENCIES_HPP
+
+#include <mrdocs/Platform.hpp>
+#include <mrdocs/Dom.hpp>
+#include <mrdocs/Metadata/Symbols.hpp>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace clang {
+namespace mrdocs {
+
+/** Records the symbols accessed by the current thread.
+
+    While an instance exists, every symbol looked
+    up through a @ref DomCorpus on the thread which
+    constructed it is recorded. Generators use this
+    to find the symbols a page depends on.
+
+    The Dom objects created while recording are
+    not shared with other threads, so that a symbol
+    reached through an object built for an earlier
+    page is still looked up, and recorded.
+*/
+class DomDependencies
+{
+    DomDependencies* prev_;
+    std::unordered_set<SymbolID> ids_;
+    std::unordered_map<SymbolID, dom::Object> objects_;
+
+public:
+    /** Constructor.
+
+        Recording starts on the calling thread.
+    */
+    DomDependencies() noexcept;
+
+    /** Destructor.
+
+        Recording stops, and any enclosing
+        instance is restored.
+    */
+    ~DomDependencies();
+
+    DomDependencies(DomDependencies const&) = delete;
+    DomDependencies& operator=(DomDependencies const&) = delete;
+
+    /** Return the instance recording on this thread, or `nullptr`.
+    */
+    static
+    DomDependencies*
+    current() noexcept;
+
+    /** Record a symbol.
+    */
+    void
+    insert(SymbolID const& id)
+    {
+        ids_.insert(id);
+    }
+
+    /** Return the recorded symbols.
+    */
+    std::unordered_set<SymbolID> const&
+    ids() const noexcept
+    {
+        return ids_;
+    }
+
+    /** Return the Dom objects created while recording.
+    */
+    std::unordered_map<SymbolID, dom::Object>&
+    objects() noexcept
+    {
+        return objects_;
+    }
+};
+
+} // mrdocs
+} // clang
+
+#endif
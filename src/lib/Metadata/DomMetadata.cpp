@@ -9,6 +9,7 @@
 // Official repository: https://github.com/cppalliance/mrdocs
 //
 
+#include "lib/Metadata/DomDependencies.hpp"
 #include "lib/Support/Radix.hpp"
 #include "lib/Support/SafeNames.hpp"
 #include <mrdocs/Metadata.hpp>
@@ -927,6 +928,17 @@ public:
         if(! I)
             return {}; // VFALCO Hack
 
+        if(auto* deps = DomDependencies::current())
+        {
+            deps->insert(id);
+            auto& objects = deps->objects();
+            if(auto it = objects.find(id); it != objects.end())
+                return it->second;
+            auto obj = create(*I);
+            objects.emplace(id, obj);
+            return obj;
+        }
+
         std::lock_guard<std::mutex> lock(mutex_);
         auto it = cache_.find(id);
         if(it == cache_.end())
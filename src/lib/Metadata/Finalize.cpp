@@ -12,45 +12,142 @@
 #include "lib/Lib/Info.hpp"
 #include "lib/Support/NameParser.hpp"
 #include <mrdocs/Metadata.hpp>
+#include <mrdocs/Support/ThreadPool.hpp>
+#include <llvm/ADT/DenseMap.h>
+#include <llvm/ADT/StringRef.h>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <mutex>
+#include <optional>
 #include <ranges>
 #include <span>
 
 namespace clang {
 namespace mrdocs {
 
+/** The results of resolving references.
+
+    A lookup for the same text from the same context
+    always finds the same symbol, and references to
+    the same few symbols tend to be repeated in the
+    documentation of most symbols of a scope. The
+    results are shared by every finalizer, which is
+    why the table is divided into shards.
+*/
+class ReferenceMemo
+{
+    using key_type = std::pair<const Info*, llvm::StringRef>;
+
+    struct Shard
+    {
+        std::mutex mutex;
+        llvm::DenseMap<key_type, const Info*> results;
+    };
+
+    std::array<Shard, 64> shards_;
+    std::atomic<std::size_t> hits_ = 0;
+    std::atomic<std::size_t> misses_ = 0;
+
+    Shard&
+    getShard(key_type const& key) noexcept
+    {
+        return shards_[llvm::DenseMapInfo<key_type>::getHashValue(
+            key) % shards_.size()];
+    }
+
+public:
+    /** Return the symbol found by a lookup, if it was memoized.
+
+        The result is null if the lookup found nothing.
+    */
+    std::optional<const Info*>
+    find(
+        const Info* context,
+        llvm::StringRef text)
+    {
+        key_type const key(context, text);
+        Shard& shard = getShard(key);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        auto it = shard.results.find(key);
+        if(it == shard.results.end())
+        {
+            ++misses_;
+            return std::nullopt;
+        }
+        ++hits_;
+        return it->second;
+    }
+
+    void
+    insert(
+        const Info* context,
+        llvm::StringRef text,
+        const Info* found)
+    {
+        key_type const key(context, text);
+        Shard& shard = getShard(key);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        shard.results.try_emplace(key, found);
+    }
+
+    void
+    reportEnd() const
+    {
+        std::size_t const hits = hits_.load();
+        std::size_t const total = hits + misses_.load();
+        if(total == 0)
+            return;
+        report::debug(
+            "Resolved {} references, {} from the memo ({:.1f}%)",
+            total, hits, 100.0 * hits / total);
+    }
+};
+
 /** Finalizes a set of Info.
 
     This removes any references to SymbolIDs
-    which do not exist.
+    which do not exist, and resolves the references
+    in the documentation of each symbol.
 
     References which should always be valid are not checked.
+
+    Each symbol is finalized independently, so the
+    symbols of a set may be divided between several
+    finalizers running concurrently. Since resolving
+    a reference reads the types of other symbols, the
+    references are only resolved once every symbol
+    has had its dangling IDs removed.
 */
 class Finalizer
 {
-    InfoSet& info_;
+    InfoTable& info_;
     SymbolLookup& lookup_;
+    ReferenceMemo& memo_;
     Info* current_ = nullptr;
 
-    bool resolveReference(doc::Reference& ref)
+    /** Return the symbol named by a reference.
+
+        @param accept_current Whether the current
+        declaration is an acceptable result.
+    */
+    const Info*
+    lookupReference(
+        doc::Reference const& ref,
+        bool accept_current)
     {
         auto parse_result = parseIdExpression(ref.string);
         if(! parse_result)
-            return false;
+            return nullptr;
 
         if(parse_result->name.empty())
-            return false;
+            return nullptr;
 
         auto is_acceptable = [&](const Info& I) -> bool
         {
-            // if we are copying the documentation of the
-            // referenced symbol, ignore the current declaration
-            if(ref.kind == doc::Kind::copied)
-                return &I != current_;
-            // otherwise, consider the result to be acceptable
-            return true;
+            return accept_current || &I != current_;
         };
 
-        const Info* found = nullptr;
         if(parse_result->qualified)
         {
             Info* context = current_;
@@ -62,22 +159,45 @@ class Finalizer
             if(parse_result->qualifier.empty())
             {
                 MRDOCS_ASSERT(info_.contains(SymbolID::global));
-                context = info_.find(SymbolID::global)->get();
+                context = info_.find(SymbolID::global);
             }
-            found = lookup_.lookupQualified(
+            return lookup_.lookupQualified(
                 context,
                 qualifier,
                 parse_result->name,
                 is_acceptable);
         }
+        return lookup_.lookupUnqualified(
+            current_,
+            parse_result->name,
+            is_acceptable);
+    }
+
+    bool resolveReference(doc::Reference& ref)
+    {
+        // the memo holds the first symbol found from the
+        // context of the current declaration. the kind of
+        // reference only determines whether the current
+        // declaration itself is acceptable, so references
+        // of every kind share the memoized results
+        const Info* context =
+            lookup_.adjustLookupContext(current_);
+        const Info* found;
+        if(auto memoized = memo_.find(context, ref.string))
+        {
+            found = *memoized;
+        }
         else
         {
-            found = lookup_.lookupUnqualified(
-                current_,
-                parse_result->name,
-                is_acceptable);
+            found = lookupReference(ref, true);
+            memo_.insert(context, ref.string, found);
         }
 
+        // if we are copying the documentation of the
+        // referenced symbol, ignore the current declaration
+        if(ref.kind == doc::Kind::copied && found == current_)
+            found = lookupReference(ref, false);
+
         // prevent recursive documentation copies
         if(ref.kind == doc::Kind::copied &&
             found && found->id == current_->id)
@@ -250,24 +370,35 @@ class Finalizer
 
 public:
     Finalizer(
-        InfoSet& Info,
-        SymbolLookup& Lookup)
+        InfoTable& Info,
+        SymbolLookup& Lookup,
+        ReferenceMemo& Memo)
         : info_(Info)
         , lookup_(Lookup)
+        , memo_(Memo)
     {
     }
 
-    void finalize(Info& I)
+    /** Remove the references to symbols which do not exist.
+    */
+    void pruneSymbols(Info& I)
     {
         current_ = &I;
         visit(I, *this);
     }
 
+    /** Resolve the references in the documentation.
+    */
+    void resolveReferences(Info& I)
+    {
+        current_ = &I;
+        finalize(I.javadoc);
+    }
+
     void operator()(NamespaceInfo& I)
     {
         check(I.Namespace);
         check(I.Members);
-        finalize(I.javadoc);
         // finalize(I.Specializations);
     }
 
@@ -275,7 +406,6 @@ public:
     {
         check(I.Namespace);
         check(I.Members);
-        finalize(I.javadoc);
         // finalize(I.Specializations);
         finalize(I.Template);
         finalize(I.Bases);
@@ -285,7 +415,6 @@ public:
     {
         check(I.Namespace);
         check(I.Members);
-        finalize(I.javadoc);
         finalize(I.Primary);
         finalize(I.Args);
     }
@@ -293,7 +422,6 @@ public:
     void operator()(FunctionInfo& I)
     {
         check(I.Namespace);
-        finalize(I.javadoc);
         finalize(I.Template);
         finalize(I.ReturnType);
         finalize(I.Params);
@@ -302,7 +430,6 @@ public:
     void operator()(TypedefInfo& I)
     {
         check(I.Namespace);
-        finalize(I.javadoc);
         finalize(I.Template);
         finalize(I.Type);
     }
@@ -311,21 +438,18 @@ public:
     {
         check(I.Namespace);
         check(I.Members);
-        finalize(I.javadoc);
         finalize(I.UnderlyingType);
     }
 
     void operator()(FieldInfo& I)
     {
         check(I.Namespace);
-        finalize(I.javadoc);
         finalize(I.Type);
     }
 
     void operator()(VariableInfo& I)
     {
         check(I.Namespace);
-        finalize(I.javadoc);
         finalize(I.Template);
         finalize(I.Type);
     }
@@ -333,7 +457,6 @@ public:
     void operator()(FriendInfo& I)
     {
         check(I.Namespace);
-        finalize(I.javadoc);
         finalize(I.FriendSymbol);
         finalize(I.FriendType);
     }
@@ -341,27 +464,64 @@ public:
     void operator()(EnumeratorInfo& I)
     {
         check(I.Namespace);
-        finalize(I.javadoc);
     }
 
     void operator()(GuideInfo& I)
     {
         check(I.Namespace);
-        finalize(I.javadoc);
         finalize(I.Template);
         finalize(I.Deduced);
         finalize(I.Params);
     }
 };
 
-void finalize(InfoSet& Info, SymbolLookup& Lookup)
+mrdocs::Expected<void>
+finalize(
+    InfoTable& Info,
+    SymbolLookup& Lookup,
+    ThreadPool& threadPool)
 {
-    Finalizer visitor(Info, Lookup);
-    for(auto& I : Info)
+    std::vector<mrdocs::Info*> infos(Info.begin(), Info.end());
+
+    // a few chunks per thread keeps every thread
+    // busy without posting a task for each symbol
+    std::size_t const chunks = std::max<std::size_t>(
+        threadPool.getThreadCount(), 1) * 4;
+    std::size_t const chunk_size = std::max<std::size_t>(
+        (infos.size() + chunks - 1) / chunks, 1);
+
+    ReferenceMemo memo;
+    auto run = [&](auto const& fn)
     {
-        MRDOCS_ASSERT(I);
-        visitor.finalize(*I);
-    }
+        TaskGroup taskGroup(threadPool);
+        for(std::size_t i = 0; i < infos.size(); i += chunk_size)
+        {
+            std::span<mrdocs::Info*> chunk(infos.data() + i,
+                std::min(chunk_size, infos.size() - i));
+            taskGroup.async(
+                [&, chunk]
+                {
+                    Finalizer finalizer(Info, Lookup, memo);
+                    for(mrdocs::Info* I : chunk)
+                        fn(finalizer, *I);
+                });
+        }
+        return taskGroup.wait();
+    };
+
+    auto errors = run([](Finalizer& finalizer, mrdocs::Info& I)
+    {
+        finalizer.pruneSymbols(I);
+    });
+    if(errors.empty())
+        errors = run([](Finalizer& finalizer, mrdocs::Info& I)
+        {
+            finalizer.resolveReferences(I);
+        });
+    if(! errors.empty())
+        return Unexpected(errors);
+    memo.reportEnd();
+    return {};
 }
 
 } // mrdocs
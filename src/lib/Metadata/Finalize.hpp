@@ -13,11 +13,24 @@
 
 #include "lib/Lib/Info.hpp"
 #include "lib/Lib/Lookup.hpp"
+#include <mrdocs/Support/Error.hpp>
+#include <mrdocs/Support/ThreadPool.hpp>
 
 namespace clang {
 namespace mrdocs {
 
-void finalize(InfoSet& Info, SymbolLookup& Lookup);
+/** Finalize every symbol in a set.
+
+    The symbols are divided into chunks which are
+    finalized concurrently on the thread pool.
+    The lookup tables are only read, and each
+    symbol is only modified by its own task.
+*/
+mrdocs::Expected<void>
+finalize(
+    InfoTable& Info,
+    SymbolLookup& Lookup,
+    ThreadPool& threadPool);
 
 } // mrdocs
 } // clang
@@ -13,6 +13,7 @@
 #include <mrdocs/Metadata.hpp>
 #include <mrdocs/Platform.hpp>
 #include <llvm/ADT/STLExtras.h>
+#include <unordered_set>
 
 namespace clang {
 namespace mrdocs {
@@ -48,30 +49,43 @@ struct LocationLess
     }
 };
 
+// the total size of two lists of symbols below
+// which searching the list is faster than hashing
+constexpr std::size_t linearSearchLimit = 32;
+
+/** Append the symbols of one list which are not in another.
+
+    `seen` holds the symbols of `list` once it becomes
+    too large to be searched. It is filled on first use,
+    and must be used for every merge into `list`.
+*/
 void
 reduceSymbolIDs(
     std::vector<SymbolID>& list,
-    std::vector<SymbolID>&& otherList)
+    std::vector<SymbolID>&& otherList,
+    std::unordered_set<SymbolID>& seen)
 {
-    for(auto const& id : otherList)
+    if(otherList.empty())
+        return;
+    if(seen.empty() &&
+        list.size() + otherList.size() <= linearSearchLimit)
     {
-        auto it = llvm::find(list, id);
-        if(it != list.end())
-            continue;
-        list.push_back(id);
+        for(auto const& id : otherList)
+        {
+            auto it = llvm::find(list, id);
+            if(it != list.end())
+                continue;
+            list.push_back(id);
+        }
+        return;
     }
-}
-
-void
-reduceLookups(
-    std::unordered_map<std::string, std::vector<SymbolID>>& I,
-    std::unordered_map<std::string, std::vector<SymbolID>>&& Other)
-{
-    I.merge(std::move(Other));
-    for(auto& [name, ids] : Other)
+    if(seen.size() < list.size())
+        seen.insert(list.begin(), list.end());
+    list.reserve(list.size() + otherList.size());
+    for(auto const& id : otherList)
     {
-        auto [it, created] = I.try_emplace(name);
-        reduceSymbolIDs(it->second, std::move(ids));
+        if(seen.insert(id).second)
+            list.push_back(id);
     }
 }
 
@@ -117,10 +131,46 @@ void mergeInfo(Info& I, Info&& Other)
         merge(*I.javadoc, std::move(*Other.javadoc));
 }
 
-void mergeScopeInfo(ScopeInfo& I, ScopeInfo&& Other)
+void
+reduceScope(
+    ScopeInfo& I,
+    ScopeInfo&& Other,
+    ScopeMembers& seen)
+{
+    reduceSymbolIDs(I.Members, std::move(Other.Members), seen.members);
+    Other.Members.clear();
+
+    // names which are not in I are moved as a whole
+    I.Lookups.merge(Other.Lookups);
+    for(auto& [name, ids] : Other.Lookups)
+    {
+        auto it = I.Lookups.find(name);
+        MRDOCS_ASSERT(it != I.Lookups.end());
+        reduceSymbolIDs(it->second, std::move(ids),
+            seen.lookups[name]);
+    }
+    Other.Lookups.clear();
+}
+
+void
+reduceScopes(
+    ScopeInfo& I,
+    std::vector<ScopeInfo*> const& Others)
+{
+    // one set is used for every scope, so each
+    // member is hashed once rather than once
+    // per merged scope
+    ScopeMembers seen;
+    for(ScopeInfo* Other : Others)
+        reduceScope(I, std::move(*Other), seen);
+}
+
+static void mergeScopeInfo(ScopeInfo& I, ScopeInfo&& Other)
 {
-    reduceSymbolIDs(I.Members, std::move(Other.Members));
-    reduceLookups(I.Lookups, std::move(Other.Lookups));
+    // callers which merge many scopes into one
+    // keep a ScopeMembers, see reduceScope
+    ScopeMembers seen;
+    reduceScope(I, std::move(Other), seen);
 }
 
 static void mergeSourceInfo(
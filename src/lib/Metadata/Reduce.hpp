@@ -13,9 +13,14 @@
 #define MRDOCS_LIB_METADATA_REDUCE_HPP
 
 #include <mrdocs/Metadata/Info.hpp>
+#include <mrdocs/Metadata/Scope.hpp>
 #include <mrdocs/MetadataFwd.hpp>
 #include <mrdocs/Support/Error.hpp>
+#include <concepts>
 #include <memory>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
 namespace clang {
@@ -33,6 +38,65 @@ void merge(FriendInfo& I, FriendInfo&& Other);
 void merge(EnumeratorInfo& I, EnumeratorInfo&& Other);
 void merge(GuideInfo& I, GuideInfo&& Other);
 
+/** The members of a scope which were already merged.
+
+    Merging a scope into another requires the set of
+    members of the destination. The same object is
+    used for every merge into a scope, so that the
+    set is built once instead of once per merge.
+*/
+struct ScopeMembers
+{
+    std::unordered_set<SymbolID> members;
+    std::unordered_map<std::string,
+        std::unordered_set<SymbolID>> lookups;
+};
+
+/** Merge the members and lookups of a scope into another.
+
+    The time taken is linear in the number of members
+    of `Other`. The members and lookups of `Other` are
+    left empty.
+
+    @param seen The members of `I` merged so far. The
+    same object must be used for every merge into `I`.
+*/
+void
+reduceScope(
+    ScopeInfo& I,
+    ScopeInfo&& Other,
+    ScopeMembers& seen);
+
+/** Merge an Info into another of the same type.
+
+    This is the same as `merge(I, std::move(Other))`,
+    except that the members of scopes are merged with
+    @ref reduceScope.
+*/
+template<class T>
+void
+merge(
+    T& I,
+    T&& Other,
+    ScopeMembers& seen)
+{
+    if constexpr(std::derived_from<T, ScopeInfo>)
+        reduceScope(I, std::move(Other), seen);
+    merge(I, std::move(Other));
+}
+
+/** Merge the members and lookups of many scopes into one.
+
+    The order of the members is the same as when the
+    scopes are merged one at a time, but the time taken
+    is linear in the total number of members. The
+    members and lookups of `Others` are left empty.
+*/
+void
+reduceScopes(
+    ScopeInfo& I,
+    std::vector<ScopeInfo*> const& Others);
+
 //
 // This file defines the merging of different types of infos. The data in the
 // calling Info is preserved during a merge unless that field is empty or
@@ -55,6 +119,17 @@ reduce(
     MRDOCS_ASSERT(! Values.empty() && Values[0]);
     std::unique_ptr<Info> Merged = std::make_unique<T>(Values[0]->id);
     T* Tmp = static_cast<T*>(Merged.get());
+    if constexpr(std::derived_from<T, ScopeInfo>)
+    {
+        if(Values.size() > 1)
+        {
+            std::vector<ScopeInfo*> Scopes;
+            Scopes.reserve(Values.size());
+            for (auto& I : Values)
+                Scopes.push_back(static_cast<T*>(I.get()));
+            reduceScopes(*Tmp, Scopes);
+        }
+    }
     for (auto& I : Values)
         merge(*Tmp, std::move(*static_cast<T*>(I.get())));
     return Merged;
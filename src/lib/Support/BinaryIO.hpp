@@ -0,0 +1,116 @@
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+// Copyright (c) 2023 Vinnie Falco (vinnie.falco@gmail.com)
+//
+// Official repository: https://github.com/cppalliance/mrdocs
+//
+
+#ifndef MRDOCS_LIB_SUPPORT_BINARYIO_HPP
+#define MRDOCS_LIB_SUPPORT_BINARYIO_HPP
+
+#include <mrdocs/Platform.hpp>
+#include <llvm/ADT/StringRef.h>
+#include <llvm/Support/raw_ostream.h>
+#include <cstdint>
+#include <cstring>
+
+namespace clang {
+namespace mrdocs {
+
+/** Write an integer in native byte order.
+
+    The files written with these functions are
+    caches and intermediate results, which are
+    only read back on the same kind of machine.
+*/
+inline
+void
+writeInt(
+    llvm::raw_ostream& os,
+    std::uint64_t value)
+{
+    os.write(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+/** Write a string preceded by its size.
+*/
+inline
+void
+writeString(
+    llvm::raw_ostream& os,
+    llvm::StringRef str)
+{
+    writeInt(os, str.size());
+    os << str;
+}
+
+/** Reads the fields written by writeInt and writeString.
+
+    Every function returns `false` if the
+    end of the buffer is reached, in which
+    case the data is considered invalid.
+*/
+class BinaryReader
+{
+    llvm::StringRef data_;
+
+public:
+    explicit
+    BinaryReader(llvm::StringRef data) noexcept
+        : data_(data)
+    {
+    }
+
+    /** Return `true` if every byte was read.
+    */
+    bool
+    empty() const noexcept
+    {
+        return data_.empty();
+    }
+
+    /** Return the bytes which were not read yet.
+    */
+    llvm::StringRef
+    remaining() const noexcept
+    {
+        return data_;
+    }
+
+    bool
+    readBytes(
+        std::size_t size,
+        llvm::StringRef& bytes) noexcept
+    {
+        if(data_.size() < size)
+            return false;
+        bytes = data_.take_front(size);
+        data_ = data_.drop_front(size);
+        return true;
+    }
+
+    bool
+    readInt(std::uint64_t& value) noexcept
+    {
+        llvm::StringRef bytes;
+        if(! readBytes(sizeof(value), bytes))
+            return false;
+        std::memcpy(&value, bytes.data(), sizeof(value));
+        return true;
+    }
+
+    bool
+    readString(llvm::StringRef& str) noexcept
+    {
+        std::uint64_t size;
+        return readInt(size) && readBytes(size, str);
+    }
+};
+
+} // mrdocs
+} // clang
+
+#endif
@@ -0,0 +1,261 @@
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+// Copyright (c) 2023 Vinnie Falco (vinnie.falco@gmail.com)
+//
+// Official repository: https://github.com/cppalliance/mrdocs
+//
+
+#include "lib/Support/CachingFileSystem.hpp"
+#include <llvm/ADT/SmallString.h>
+#include <llvm/ADT/StringExtras.h>
+#include <llvm/Support/xxhash.h>
+
+namespace clang {
+namespace mrdocs {
+
+namespace {
+
+/** A file whose contents are held by a FileSystemCache.
+*/
+class CachedFile
+    : public llvm::vfs::File
+{
+    llvm::vfs::Status status_;
+    llvm::StringRef name_;
+    llvm::StringRef contents_;
+
+public:
+    CachedFile(
+        llvm::vfs::Status status,
+        llvm::StringRef name,
+        llvm::StringRef contents)
+        : status_(std::move(status))
+        , name_(name)
+        , contents_(contents)
+    {
+    }
+
+    llvm::ErrorOr<llvm::vfs::Status>
+    status() override
+    {
+        return status_;
+    }
+
+    llvm::ErrorOr<std::string>
+    getName() override
+    {
+        // the name reported by the underlying file,
+        // which can differ from the requested one
+        return name_.str();
+    }
+
+    llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>>
+    getBuffer(
+        const llvm::Twine& Name,
+        int64_t,
+        bool RequiresNullTerminator,
+        bool) override
+    {
+        // the cached buffer is always null terminated
+        return llvm::MemoryBuffer::getMemBuffer(
+            contents_, Name.str(), RequiresNullTerminator);
+    }
+
+    std::error_code
+    close() override
+    {
+        return {};
+    }
+};
+
+} // (anon)
+
+FileSystemCache::
+FileSystemCache(
+    std::function<llvm::IntrusiveRefCntPtr<
+        llvm::vfs::FileSystem>()> makeFileSystem)
+    : makeFileSystem_(std::move(makeFileSystem))
+{
+}
+
+FileSystemCache::
+~FileSystemCache() = default;
+
+llvm::IntrusiveRefCntPtr<llvm::vfs::FileSystem>
+FileSystemCache::
+getFileSystem()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto& FS = threads_[std::this_thread::get_id()];
+    if(! FS)
+        FS = llvm::makeIntrusiveRefCnt<CachingFileSystem>(
+            makeFileSystem_(), *this);
+    return FS;
+}
+
+auto
+FileSystemCache::
+getShard(llvm::StringRef path) noexcept ->
+    Shard&
+{
+    return shards_[llvm::xxh3_64bits(
+        llvm::arrayRefFromStringRef(path)) % shards_.size()];
+}
+
+llvm::ErrorOr<llvm::vfs::Status>
+FileSystemCache::
+status(
+    llvm::StringRef path,
+    llvm::StringRef name,
+    llvm::vfs::FileSystem& FS)
+{
+    Shard& shard = getShard(path);
+    {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        if(auto it = shard.stats.find(path);
+            it != shard.stats.end())
+        {
+            ++statsCached_;
+            if(it->second.error)
+                return it->second.error;
+            return llvm::vfs::Status::copyWithNewName(
+                it->second.status, name);
+        }
+    }
+
+    StatEntry entry;
+    auto result = FS.status(path);
+    if(result)
+        entry.status = *result;
+    else
+        entry.error = result.getError();
+    {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        shard.stats.try_emplace(path, entry);
+    }
+    if(entry.error)
+        return entry.error;
+    return llvm::vfs::Status::copyWithNewName(
+        entry.status, name);
+}
+
+llvm::ErrorOr<std::unique_ptr<llvm::vfs::File>>
+FileSystemCache::
+openFileForRead(
+    llvm::StringRef path,
+    llvm::StringRef name,
+    llvm::vfs::FileSystem& FS)
+{
+    // precompiled headers are large, and only
+    // read by the files of one group
+    bool cacheable = ! path.ends_with(".pch");
+    Shard& shard = getShard(path);
+    {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        if(auto it = shard.files.find(path);
+            it != shard.files.end())
+        {
+            bytesCached_ += it->second.buffer->getBufferSize();
+            return std::unique_ptr<llvm::vfs::File>(
+                std::make_unique<CachedFile>(
+                    llvm::vfs::Status::copyWithNewName(
+                        it->second.status, name),
+                    it->second.name,
+                    it->second.buffer->getBuffer()));
+        }
+        // don't probe files known not to exist
+        if(auto it = shard.stats.find(path);
+            it != shard.stats.end() && it->second.error)
+            return it->second.error;
+        // only files opened more than once are kept, so
+        // that the main file of each translation unit is
+        // not held in memory until the end of the run
+        if(cacheable)
+            cacheable = ++shard.opens[path] > 1;
+    }
+
+    if(! cacheable)
+    {
+        auto file = FS.openFileForRead(name);
+        if(file)
+        {
+            if(auto status = (*file)->status())
+                bytesRead_ += status->getSize();
+        }
+        return file;
+    }
+
+    auto file = FS.openFileForRead(path);
+    if(! file)
+        return file.getError();
+    auto status = (*file)->status();
+    if(! status)
+        return status.getError();
+    auto real_name = (*file)->getName();
+    if(! real_name)
+        return real_name.getError();
+    auto buffer = (*file)->getBuffer(
+        path, status->getSize(), true, false);
+    if(! buffer)
+        return buffer.getError();
+    bytesRead_ += (*buffer)->getBufferSize();
+
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    // if another thread read the file first, its entry is used
+    auto it = shard.files.try_emplace(path, ContentEntry{
+        *status, std::move(*real_name), std::move(*buffer)}).first;
+    return std::unique_ptr<llvm::vfs::File>(
+        std::make_unique<CachedFile>(
+            llvm::vfs::Status::copyWithNewName(
+                it->second.status, name),
+            it->second.name,
+            it->second.buffer->getBuffer()));
+}
+
+void
+FileSystemCache::
+reportEnd(report::Level level) const
+{
+    auto const to_mb = [](std::size_t bytes)
+    {
+        return bytes / (1024.0 * 1024.0);
+    };
+    report::format(level,
+        "File cache: {:.1f} MB read from disk, {:.1f} MB "
+        "served from cache, {} stats served from cache",
+        to_mb(bytesRead_.load()),
+        to_mb(bytesCached_.load()),
+        statsCached_.load());
+}
+
+//------------------------------------------------
+
+llvm::ErrorOr<llvm::vfs::Status>
+CachingFileSystem::
+status(const llvm::Twine& Path)
+{
+    llvm::SmallString<256> name;
+    Path.toVector(name);
+    llvm::SmallString<256> path(name);
+    if(auto ec = makeAbsolute(path))
+        return ec;
+    return cache_.status(path, name, getUnderlyingFS());
+}
+
+llvm::ErrorOr<std::unique_ptr<llvm::vfs::File>>
+CachingFileSystem::
+openFileForRead(const llvm::Twine& Path)
+{
+    llvm::SmallString<256> name;
+    Path.toVector(name);
+    llvm::SmallString<256> path(name);
+    if(auto ec = makeAbsolute(path))
+        return ec;
+    return cache_.openFileForRead(path, name, getUnderlyingFS());
+}
+
+} // mrdocs
+} // clang
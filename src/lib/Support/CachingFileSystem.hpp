@@ -0,0 +1,180 @@
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+// Copyright (c) 2023 Vinnie Falco (vinnie.falco@gmail.com)
+//
+// Official repository: https://github.com/cppalliance/mrdocs
+//
+
+#ifndef MRDOCS_LIB_SUPPORT_CACHINGFILESYSTEM_HPP
+#define MRDOCS_LIB_SUPPORT_CACHINGFILESYSTEM_HPP
+
+#include <mrdocs/Platform.hpp>
+#include <mrdocs/Support/Error.hpp>
+#include <llvm/ADT/IntrusiveRefCntPtr.h>
+#include <llvm/ADT/StringMap.h>
+#include <llvm/Support/MemoryBuffer.h>
+#include <llvm/Support/VirtualFileSystem.h>
+#include <array>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+
+namespace clang {
+namespace mrdocs {
+
+/** The stat results and contents of files, shared by many file systems.
+
+    Entries are keyed by absolute path. Once an entry
+    is stored it is never modified, so the status and
+    contents it holds can be used concurrently by every
+    thread. The cache is split into shards to reduce
+    contention between threads.
+
+    Failed stats are cached as well, since the
+    same missing files are probed by every translation
+    unit while searching the include directories.
+
+    The contents of a file are only cached once it is
+    opened a second time, so the main files of the
+    translation units are not kept in memory.
+    Precompiled headers are never cached.
+*/
+class FileSystemCache
+{
+public:
+    /** Create a cache of files read through a file system.
+
+        @param makeFileSystem A function returning
+        a new instance of the underlying file system.
+        Each thread receives its own instance, so that
+        threads can use different working directories.
+    */
+    explicit
+    FileSystemCache(
+        std::function<llvm::IntrusiveRefCntPtr<
+            llvm::vfs::FileSystem>()> makeFileSystem);
+
+    ~FileSystemCache();
+
+    /** Return the caching file system of the calling thread.
+
+        The same instance is returned every time
+        a thread calls this function.
+    */
+    llvm::IntrusiveRefCntPtr<llvm::vfs::FileSystem>
+    getFileSystem();
+
+    /** Return the number of bytes read from disk.
+    */
+    std::size_t
+    bytesRead() const noexcept
+    {
+        return bytesRead_.load();
+    }
+
+    /** Return the number of bytes served from the cache.
+    */
+    std::size_t
+    bytesCached() const noexcept
+    {
+        return bytesCached_.load();
+    }
+
+    /** Report the bytes read from disk and served from the cache.
+    */
+    void
+    reportEnd(report::Level level) const;
+
+private:
+    friend class CachingFileSystem;
+
+    struct StatEntry
+    {
+        std::error_code error;
+        llvm::vfs::Status status;
+    };
+
+    struct ContentEntry
+    {
+        llvm::vfs::Status status;
+        std::string name;
+        std::unique_ptr<llvm::MemoryBuffer> buffer;
+    };
+
+    struct Shard
+    {
+        std::mutex mutex;
+        llvm::StringMap<StatEntry> stats;
+        llvm::StringMap<ContentEntry> files;
+        llvm::StringMap<unsigned> opens;
+    };
+
+    Shard&
+    getShard(llvm::StringRef path) noexcept;
+
+    llvm::ErrorOr<llvm::vfs::Status>
+    status(
+        llvm::StringRef path,
+        llvm::StringRef name,
+        llvm::vfs::FileSystem& FS);
+
+    llvm::ErrorOr<std::unique_ptr<llvm::vfs::File>>
+    openFileForRead(
+        llvm::StringRef path,
+        llvm::StringRef name,
+        llvm::vfs::FileSystem& FS);
+
+    std::function<llvm::IntrusiveRefCntPtr<
+        llvm::vfs::FileSystem>()> makeFileSystem_;
+    std::array<Shard, 16> shards_;
+
+    std::mutex mutex_;
+    std::unordered_map<std::thread::id,
+        llvm::IntrusiveRefCntPtr<llvm::vfs::FileSystem>> threads_;
+
+    std::atomic<std::size_t> bytesRead_ = 0;
+    std::atomic<std::size_t> bytesCached_ = 0;
+    std::atomic<std::size_t> statsCached_ = 0;
+};
+
+//------------------------------------------------
+
+/** A file system which serves stats and contents from a shared cache.
+
+    Every request which misses the cache is
+    forwarded to the underlying file system and
+    its result is stored. Directory iteration and
+    the working directory are not cached.
+*/
+class CachingFileSystem
+    : public llvm::vfs::ProxyFileSystem
+{
+    FileSystemCache& cache_;
+
+public:
+    CachingFileSystem(
+        llvm::IntrusiveRefCntPtr<llvm::vfs::FileSystem> FS,
+        FileSystemCache& cache)
+        : ProxyFileSystem(std::move(FS))
+        , cache_(cache)
+    {
+    }
+
+    llvm::ErrorOr<llvm::vfs::Status>
+    status(const llvm::Twine& Path) override;
+
+    llvm::ErrorOr<std::unique_ptr<llvm::vfs::File>>
+    openFileForRead(const llvm::Twine& Path) override;
+};
+
+} // mrdocs
+} // clang
+
+#endif
@@ -54,6 +54,17 @@ build(
     return buildOne(fileName.str(), corpus);
 }
 
+Error
+Generator::
+buildIncremental(
+    std::string_view outputPath,
+    Corpus const& corpus,
+    Corpus const&,
+    std::unordered_set<SymbolID> const&) const
+{
+    return build(outputPath, corpus);
+}
+
 Error
 Generator::
 buildOne(
@@ -0,0 +1,211 @@
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+// Copyright (c) 2023 Vinnie Falco (vinnie.falco@gmail.com)
+//
+// Official repository: https://github.com/cppalliance/mrdocs
+//
+
+#include "lib/AST/Bitcode.hpp"
+#include "lib/Lib/ConfigImpl.hpp"
+#include "lib/Lib/CorpusDiff.hpp"
+#include "lib/Lib/CorpusImpl.hpp"
+#include "lib/Support/Radix.hpp"
+#include <mrdocs/Metadata.hpp>
+#include <mrdocs/Support/ThreadPool.hpp>
+#include <test_suite/test_suite.hpp>
+#include <llvm/ADT/SmallString.h>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/Path.h>
+#include <llvm/Support/raw_ostream.h>
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace clang {
+namespace mrdocs {
+
+struct CorpusDiff_test
+{
+    ThreadPool threadPool_;
+    llvm::SmallString<128> dir_;
+    std::shared_ptr<ConfigImpl const> config_;
+
+    static
+    SymbolID
+    makeID(std::uint32_t n)
+    {
+        std::array<std::uint8_t, 20> bytes{};
+        bytes[0] = 3;
+        for(std::size_t i = 0; i < 4; ++i)
+            bytes[i + 1] = static_cast<std::uint8_t>(n >> (8 * i));
+        return SymbolID(bytes.data());
+    }
+
+    /** Return the symbols of a small program.
+
+        namespace a { struct S; void f(); void f(int); }
+
+        The overloads of f with IDs 3 and 4
+        are declared if listed in `overloads`.
+    */
+    static
+    std::vector<std::unique_ptr<Info>>
+    makeSymbols(std::vector<std::uint32_t> const& overloads)
+    {
+        std::vector<std::unique_ptr<Info>> result;
+
+        auto global = std::make_unique<NamespaceInfo>(SymbolID::global);
+        global->Members.push_back(makeID(1));
+        global->Lookups["a"].push_back(makeID(1));
+
+        auto a = std::make_unique<NamespaceInfo>(makeID(1));
+        a->Name = "a";
+        a->Namespace.push_back(SymbolID::global);
+        a->Members.push_back(makeID(2));
+        a->Lookups["S"].push_back(makeID(2));
+
+        auto S = std::make_unique<RecordInfo>(makeID(2));
+        S->Name = "S";
+        S->Namespace = { makeID(1), SymbolID::global };
+
+        for(std::uint32_t n : overloads)
+        {
+            auto f = std::make_unique<FunctionInfo>(makeID(n));
+            f->Name = "f";
+            f->Namespace = { makeID(1), SymbolID::global };
+            a->Members.push_back(f->id);
+            a->Lookups["f"].push_back(f->id);
+            result.push_back(std::move(f));
+        }
+
+        result.push_back(std::move(global));
+        result.push_back(std::move(a));
+        result.push_back(std::move(S));
+        return result;
+    }
+
+    /** Return a corpus of the symbols of makeSymbols.
+    */
+    std::unique_ptr<Corpus>
+    makeCorpus(
+        std::string_view name,
+        std::vector<std::uint32_t> const& overloads)
+    {
+        llvm::SmallString<128> dir(dir_);
+        llvm::sys::path::append(dir, name);
+        if(! BOOST_TEST(! llvm::sys::fs::create_directories(dir)))
+            return nullptr;
+        for(auto const& I : makeSymbols(overloads))
+        {
+            llvm::SmallString<128> path(dir);
+            llvm::sys::path::append(path, toBase16(I->id) + ".bc");
+            std::error_code ec;
+            llvm::raw_fd_ostream os(path, ec);
+            if(! BOOST_TEST(! ec))
+                return nullptr;
+            os << writeBitcode(*I);
+        }
+        auto corpus = CorpusImpl::buildFromBitcode(
+            report::Level::error, config_, dir.str());
+        if(! BOOST_TEST(corpus.has_value()))
+            return nullptr;
+        return std::move(*corpus);
+    }
+
+    static
+    bool
+    contains(
+        std::vector<SymbolID> const& ids,
+        SymbolID const& id)
+    {
+        return std::ranges::find(ids, id) != ids.end();
+    }
+
+    void
+    testUnchanged()
+    {
+        auto before = makeCorpus("unchanged-before", { 3 });
+        auto after = makeCorpus("unchanged-after", { 3 });
+        if(! before || ! after)
+            return;
+        auto diff = diffCorpora(*before, *after);
+        if(! BOOST_TEST(diff.has_value()))
+            return;
+        BOOST_TEST(diff->empty());
+        BOOST_TEST(diff->affected.empty());
+    }
+
+    void
+    testAddOverload()
+    {
+        auto before = makeCorpus("add-before", { 3 });
+        auto after = makeCorpus("add-after", { 3, 4 });
+        if(! before || ! after)
+            return;
+        auto diff = diffCorpora(*before, *after);
+        if(! BOOST_TEST(diff.has_value()))
+            return;
+        BOOST_TEST(diff->added.size() == 1);
+        BOOST_TEST(contains(diff->added, makeID(4)));
+        BOOST_TEST(diff->removed.empty());
+        BOOST_TEST(contains(diff->changed, makeID(1)));
+
+        // the scope and every member of the scope, since
+        // the overload can change the names of its siblings
+        BOOST_TEST(diff->affected.contains(makeID(1)));
+        BOOST_TEST(diff->affected.contains(makeID(2)));
+        BOOST_TEST(diff->affected.contains(makeID(3)));
+        BOOST_TEST(diff->affected.contains(makeID(4)));
+    }
+
+    void
+    testRemoveOverload()
+    {
+        auto before = makeCorpus("remove-before", { 3, 4 });
+        auto after = makeCorpus("remove-after", { 3 });
+        if(! before || ! after)
+            return;
+        auto diff = diffCorpora(*before, *after);
+        if(! BOOST_TEST(diff.has_value()))
+            return;
+        BOOST_TEST(diff->added.empty());
+        BOOST_TEST(diff->removed.size() == 1);
+        BOOST_TEST(contains(diff->removed, makeID(4)));
+
+        // removed symbols have no pages to emit
+        BOOST_TEST(! diff->affected.contains(makeID(4)));
+        BOOST_TEST(diff->affected.contains(makeID(1)));
+        BOOST_TEST(diff->affected.contains(makeID(2)));
+        BOOST_TEST(diff->affected.contains(makeID(3)));
+    }
+
+    void run()
+    {
+        if(! BOOST_TEST(! llvm::sys::fs::createUniqueDirectory(
+            "mrdocs-diff-test", dir_)))
+            return;
+        auto config = createConfig(
+            dir_.str(), dir_.str(), "", threadPool_);
+        if(BOOST_TEST(config.has_value()))
+        {
+            config_ = *config;
+            testUnchanged();
+            testAddOverload();
+            testRemoveOverload();
+        }
+        llvm::sys::fs::remove_directories(dir_);
+    }
+};
+
+TEST_SUITE(
+    CorpusDiff_test,
+    "clang.mrdocs.CorpusDiff");
+
+} // mrdocs
+} // clang
@@ -0,0 +1,295 @@
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+// Copyright (c) 2023 Vinnie Falco (vinnie.falco@gmail.com)
+//
+// Official repository: https://github.com/cppalliance/mrdocs
+//
+
+#include "lib/AST/Bitcode.hpp"
+#include "lib/Gen/bitcode/BitcodeGenerator.hpp"
+#include "lib/Lib/ConfigImpl.hpp"
+#include "lib/Lib/CorpusImpl.hpp"
+#include "lib/Support/Radix.hpp"
+#include <mrdocs/Metadata.hpp>
+#include <mrdocs/Support/ThreadPool.hpp>
+#include <test_suite/test_suite.hpp>
+#include <llvm/ADT/SmallString.h>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/MemoryBuffer.h>
+#include <llvm/Support/Path.h>
+#include <llvm/Support/raw_ostream.h>
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace clang {
+namespace mrdocs {
+
+struct CorpusImpl_test
+{
+    ThreadPool threadPool_;
+    llvm::SmallString<128> dir_;
+
+    static
+    SymbolID
+    makeID(std::uint32_t n)
+    {
+        std::array<std::uint8_t, 20> bytes{};
+        bytes[0] = 2;
+        for(std::size_t i = 0; i < 4; ++i)
+            bytes[i + 1] = static_cast<std::uint8_t>(n >> (8 * i));
+        return SymbolID(bytes.data());
+    }
+
+    /** Return the symbols of a small program.
+
+        namespace a { struct S; void f(); }
+        namespace b { struct S; }
+    */
+    static
+    std::vector<std::unique_ptr<Info>>
+    makeSymbols()
+    {
+        std::vector<std::unique_ptr<Info>> result;
+
+        auto global = std::make_unique<NamespaceInfo>(SymbolID::global);
+        global->Members = { makeID(1), makeID(4) };
+        global->Lookups["a"].push_back(makeID(1));
+        global->Lookups["b"].push_back(makeID(4));
+
+        auto a = std::make_unique<NamespaceInfo>(makeID(1));
+        a->Name = "a";
+        a->Namespace.push_back(SymbolID::global);
+        a->Members = { makeID(2), makeID(3) };
+        a->Lookups["S"].push_back(makeID(2));
+        a->Lookups["f"].push_back(makeID(3));
+
+        auto S = std::make_unique<RecordInfo>(makeID(2));
+        S->Name = "S";
+        S->Namespace = { makeID(1), SymbolID::global };
+
+        auto f = std::make_unique<FunctionInfo>(makeID(3));
+        f->Name = "f";
+        f->Namespace = { makeID(1), SymbolID::global };
+
+        auto b = std::make_unique<NamespaceInfo>(makeID(4));
+        b->Name = "b";
+        b->Namespace.push_back(SymbolID::global);
+        b->Members.push_back(makeID(5));
+        b->Lookups["S"].push_back(makeID(5));
+
+        auto bS = std::make_unique<RecordInfo>(makeID(5));
+        bS->Name = "S";
+        bS->Namespace = { makeID(4), SymbolID::global };
+
+        result.push_back(std::move(global));
+        result.push_back(std::move(a));
+        result.push_back(std::move(S));
+        result.push_back(std::move(f));
+        result.push_back(std::move(b));
+        result.push_back(std::move(bS));
+        return result;
+    }
+
+    std::string
+    makePath(std::string_view name) const
+    {
+        llvm::SmallString<128> path(dir_);
+        llvm::sys::path::append(path, name);
+        return std::string(path.str());
+    }
+
+    bool
+    writeFile(
+        std::string const& path,
+        llvm::StringRef contents)
+    {
+        std::error_code ec;
+        llvm::raw_fd_ostream os(path, ec);
+        if(! BOOST_TEST(! ec))
+            return false;
+        os << contents;
+        return true;
+    }
+
+    std::shared_ptr<ConfigImpl const>
+    makeConfig()
+    {
+        auto config = createConfig(
+            dir_.str(), dir_.str(), "", threadPool_);
+        if(! BOOST_TEST(config.has_value()))
+            return nullptr;
+        return *config;
+    }
+
+    /** Return a corpus of the symbols of makeSymbols.
+
+        The symbols are written to one bitcode
+        file each, as the bitcode generator does.
+    */
+    std::unique_ptr<Corpus>
+    makeCorpus(std::shared_ptr<ConfigImpl const> const& config)
+    {
+        auto const dir = makePath("symbols");
+        if(! BOOST_TEST(! llvm::sys::fs::create_directories(dir)))
+            return nullptr;
+        for(auto const& I : makeSymbols())
+        {
+            llvm::SmallString<128> path(dir);
+            llvm::sys::path::append(path, toBase16(I->id) + ".bc");
+            if(! writeFile(std::string(path.str()), writeBitcode(*I)))
+                return nullptr;
+        }
+        auto corpus = CorpusImpl::buildFromBitcode(
+            report::Level::error, config, dir);
+        if(! BOOST_TEST(corpus.has_value()))
+            return nullptr;
+        return std::move(*corpus);
+    }
+
+    static
+    void
+    testSameSymbols(
+        Corpus const& expected,
+        Corpus const& actual)
+    {
+        std::size_t count = 0;
+        for(Info const& I : expected)
+        {
+            ++count;
+            Info const* other = actual.find(I.id);
+            if(! BOOST_TEST(other))
+                continue;
+            BOOST_TEST(other->Kind == I.Kind);
+            BOOST_TEST(other->Name == I.Name);
+            BOOST_TEST(other->Namespace == I.Namespace);
+        }
+        std::size_t actual_count = 0;
+        for(Info const& I : actual)
+        {
+            (void)I;
+            ++actual_count;
+        }
+        BOOST_TEST(actual_count == count);
+
+        for(auto const id : { makeID(1), makeID(4) })
+        {
+            auto const& a = expected.get<NamespaceInfo>(id);
+            auto const& b = actual.get<NamespaceInfo>(id);
+            BOOST_TEST(a.Members == b.Members);
+            BOOST_TEST(a.Lookups == b.Lookups);
+        }
+    }
+
+    void
+    testSnapshot()
+    {
+        auto config = makeConfig();
+        if(! config)
+            return;
+        auto corpus = makeCorpus(config);
+        if(! corpus)
+            return;
+
+        auto const path = makePath("corpus.snapshot");
+        auto written = static_cast<CorpusImpl const&>(
+            *corpus).writeSnapshot(path);
+        if(! BOOST_TEST(written.has_value()))
+            return;
+        auto loaded = CorpusImpl::loadSnapshot(
+            report::Level::error, config, path);
+        if(! BOOST_TEST(loaded.has_value()))
+            return;
+        testSameSymbols(*corpus, **loaded);
+
+        // a truncated snapshot is rejected
+        auto buffer = llvm::MemoryBuffer::getFile(path);
+        if(! BOOST_TEST(buffer))
+            return;
+        auto const truncated = makePath("truncated.snapshot");
+        if(! writeFile(truncated, (*buffer)->getBuffer().drop_back(
+            (*buffer)->getBufferSize() / 2)))
+            return;
+        BOOST_TEST(! CorpusImpl::loadSnapshot(
+            report::Level::error, config, truncated).has_value());
+    }
+
+    void
+    testBitcode()
+    {
+        auto config = makeConfig();
+        if(! config)
+            return;
+        auto corpus = makeCorpus(config);
+        if(! corpus)
+            return;
+        bitcode::BitcodeGenerator generator;
+
+        // one file per symbol. a::S and b::S
+        // must be written to different files
+        auto const dir = makePath("multi");
+        if(! BOOST_TEST(! llvm::sys::fs::create_directories(dir)))
+            return;
+        if(! BOOST_TEST(! generator.build(dir, *corpus)))
+            return;
+        auto multi = CorpusImpl::buildFromBitcode(
+            report::Level::error, config, dir);
+        if(BOOST_TEST(multi.has_value()))
+            testSameSymbols(*corpus, **multi);
+
+        // every symbol in one file
+        std::ostringstream os;
+        if(! BOOST_TEST(! generator.buildOne(os, *corpus)))
+            return;
+        auto const file = makePath("single.bc");
+        if(! writeFile(file, os.str()))
+            return;
+        auto single = CorpusImpl::buildFromBitcode(
+            report::Level::error, config, file);
+        if(BOOST_TEST(single.has_value()))
+            testSameSymbols(*corpus, **single);
+    }
+
+    void
+    testMissingMember()
+    {
+        auto config = makeConfig();
+        if(! config)
+            return;
+
+        // the global namespace lists
+        // a member with no bitcode
+        auto global = std::make_unique<NamespaceInfo>(SymbolID::global);
+        global->Members.push_back(makeID(1));
+        global->Lookups["a"].push_back(makeID(1));
+        auto const file = makePath("incomplete.bc");
+        if(! writeFile(file, writeBitcode(*global)))
+            return;
+        BOOST_TEST(! CorpusImpl::buildFromBitcode(
+            report::Level::error, config, file).has_value());
+    }
+
+    void run()
+    {
+        if(! BOOST_TEST(! llvm::sys::fs::createUniqueDirectory(
+            "mrdocs-corpus-test", dir_)))
+            return;
+        testSnapshot();
+        testBitcode();
+        testMissingMember();
+        llvm::sys::fs::remove_directories(dir_);
+    }
+};
+
+TEST_SUITE(
+    CorpusImpl_test,
+    "clang.mrdocs.CorpusImpl");
+
+} // mrdocs
+} // clang
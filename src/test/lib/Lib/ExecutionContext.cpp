@@ -0,0 +1,342 @@
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+// Copyright (c) 2023 Vinnie Falco (vinnie.falco@gmail.com)
+//
+// Official repository: https://github.com/cppalliance/mrdocs
+//
+
+#include "lib/AST/Bitcode.hpp"
+#include "lib/Lib/ConfigImpl.hpp"
+#include "lib/Lib/ExecutionContext.hpp"
+#include "lib/Support/Radix.hpp"
+#include <mrdocs/Metadata.hpp>
+#include <mrdocs/Support/ThreadPool.hpp>
+#include <test_suite/test_suite.hpp>
+#include <llvm/ADT/SmallString.h>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/MemoryBuffer.h>
+#include <llvm/Support/Path.h>
+#include <llvm/Support/raw_ostream.h>
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace clang {
+namespace mrdocs {
+
+struct ExecutionContext_test
+{
+    ThreadPool threadPool_;
+    llvm::SmallString<128> dir_;
+    std::shared_ptr<ConfigImpl const> config_;
+
+    static
+    SymbolID
+    makeID(std::uint32_t n)
+    {
+        std::array<std::uint8_t, 20> bytes{};
+        bytes[0] = 6;
+        for(std::size_t i = 0; i < 4; ++i)
+            bytes[i + 1] = static_cast<std::uint8_t>(n >> (8 * i));
+        return SymbolID(bytes.data());
+    }
+
+    /** Return the symbols extracted from a translation unit.
+
+        namespace a { struct S; }     // unit 0
+        namespace a { void f(); }     // unit 1
+
+        Both units declare the global namespace and `a`,
+        which are merged when the results are reduced.
+    */
+    static
+    InfoSet
+    makeUnit(int unit)
+    {
+        InfoSet result;
+        SymbolID const member = makeID(unit == 0 ? 2 : 3);
+
+        auto global = std::make_unique<NamespaceInfo>(SymbolID::global);
+        global->Members.push_back(makeID(1));
+        global->Lookups["a"].push_back(makeID(1));
+
+        auto a = std::make_unique<NamespaceInfo>(makeID(1));
+        a->Name = "a";
+        a->Namespace.push_back(SymbolID::global);
+        a->Members.push_back(member);
+
+        if(unit == 0)
+        {
+            auto S = std::make_unique<RecordInfo>(member);
+            S->Name = "S";
+            S->Namespace = { makeID(1), SymbolID::global };
+            a->Lookups["S"].push_back(member);
+            result.emplace(std::move(S));
+        }
+        else
+        {
+            auto f = std::make_unique<FunctionInfo>(member);
+            f->Name = "f";
+            f->Namespace = { makeID(1), SymbolID::global };
+            a->Lookups["f"].push_back(member);
+            result.emplace(std::move(f));
+        }
+
+        result.emplace(std::move(global));
+        result.emplace(std::move(a));
+        return result;
+    }
+
+    /** Report every unit to a context, the first one twice.
+    */
+    static
+    void
+    reportUnits(ExecutionContext& context)
+    {
+        context.report(makeUnit(0), Diagnostics());
+        context.report(makeUnit(1), Diagnostics());
+        context.report(makeUnit(0), Diagnostics());
+    }
+
+    std::string
+    makePath(std::string_view name) const
+    {
+        llvm::SmallString<128> path(dir_);
+        llvm::sys::path::append(path, name);
+        return std::string(path.str());
+    }
+
+    bool
+    writeFile(
+        std::string const& path,
+        llvm::StringRef contents)
+    {
+        std::error_code ec;
+        llvm::raw_fd_ostream os(path, ec);
+        if(! BOOST_TEST(! ec))
+            return false;
+        os << contents;
+        return true;
+    }
+
+    /** Return the reduced results of a context.
+    */
+    static
+    InfoSet
+    reduce(ExecutionContext& context)
+    {
+        auto results = context.results();
+        if(! BOOST_TEST(results.has_value()))
+            return {};
+        return std::move(*results);
+    }
+
+    /** Check that two sets hold the same symbols.
+
+        The symbols are compared by their bitcode, so
+        that every member of an Info is compared, except
+        for namespaces whose lookup table is unordered.
+    */
+    static
+    void
+    testSameInfos(
+        InfoSet const& expected,
+        InfoSet const& actual)
+    {
+        BOOST_TEST(expected.size() == actual.size());
+        for(auto const& I : expected)
+        {
+            auto it = actual.find(I->id);
+            if(! BOOST_TEST(it != actual.end()) ||
+                ! BOOST_TEST((*it)->Kind == I->Kind))
+                continue;
+            if(! I->isNamespace())
+            {
+                BOOST_TEST(writeBitcode(**it) == writeBitcode(*I));
+                continue;
+            }
+            auto const& a = static_cast<NamespaceInfo const&>(*I);
+            auto const& b = static_cast<NamespaceInfo const&>(**it);
+            BOOST_TEST(a.Name == b.Name);
+            BOOST_TEST(a.Namespace == b.Namespace);
+            BOOST_TEST(a.Members == b.Members);
+            BOOST_TEST(a.Lookups == b.Lookups);
+        }
+    }
+
+    void
+    testReduce(InfoSet const& expected)
+    {
+        // the namespaces list the members of both units
+        BOOST_TEST(expected.size() == 4);
+        auto it = expected.find(makeID(1));
+        if(! BOOST_TEST(it != expected.end()) ||
+            ! BOOST_TEST((*it)->isNamespace()))
+            return;
+        auto const& a = static_cast<NamespaceInfo const&>(**it);
+        BOOST_TEST(a.Members.size() == 2);
+        BOOST_TEST(a.Lookups.size() == 2);
+    }
+
+    void
+    testShard(InfoSet const& expected)
+    {
+        auto const path = makePath("units.shard");
+        {
+            BitcodeExecutionContext context(*config_);
+            reportUnits(context);
+            if(! BOOST_TEST(context.writeShard(path).has_value()))
+                return;
+        }
+        BitcodeExecutionContext context(*config_);
+        if(! BOOST_TEST(context.readShard(path).has_value()))
+            return;
+        testSameInfos(expected, reduce(context));
+    }
+
+    void
+    testSplitShards(InfoSet const& expected)
+    {
+        // each shard holds the results of one unit
+        std::vector<std::string> paths;
+        for(int unit = 0; unit < 2; ++unit)
+        {
+            auto const path = makePath(
+                "unit" + std::to_string(unit) + ".shard");
+            BitcodeExecutionContext context(*config_);
+            context.report(makeUnit(unit), Diagnostics());
+            if(! BOOST_TEST(context.writeShard(path).has_value()))
+                return;
+            paths.push_back(path);
+        }
+        BitcodeExecutionContext context(*config_);
+        for(auto const& path : paths)
+        {
+            if(! BOOST_TEST(context.readShard(path).has_value()))
+                return;
+        }
+        testSameInfos(expected, reduce(context));
+    }
+
+    void
+    testCorruptShard()
+    {
+        auto const path = makePath("units.shard");
+        auto buffer = llvm::MemoryBuffer::getFile(path);
+        if(! BOOST_TEST(buffer))
+            return;
+
+        // a truncated shard is rejected when read
+        auto const truncated = makePath("truncated.shard");
+        if(! writeFile(truncated, (*buffer)->getBuffer().drop_back(
+            (*buffer)->getBufferSize() / 2)))
+            return;
+        {
+            BitcodeExecutionContext context(*config_);
+            BOOST_TEST(! context.readShard(truncated).has_value());
+        }
+
+        // a shard which is not a shard
+        auto const garbage = makePath("garbage.shard");
+        if(! writeFile(garbage, "garbage"))
+            return;
+        {
+            BitcodeExecutionContext context(*config_);
+            BOOST_TEST(! context.readShard(garbage).has_value());
+        }
+
+        // a shard holding bitcode which cannot be
+        // decoded fails when the results are reduced
+        auto const invalid = makePath("invalid.shard");
+        {
+            BitcodeExecutionContext context(*config_);
+            std::vector<SerializedInfo> bitcode;
+            bitcode.push_back({makeID(1),
+                llvm::SmallString<0>("not bitcode")});
+            context.report(std::move(bitcode), Diagnostics());
+            if(! BOOST_TEST(context.writeShard(invalid).has_value()))
+                return;
+        }
+        BitcodeExecutionContext context(*config_);
+        if(! BOOST_TEST(context.readShard(invalid).has_value()))
+            return;
+        BOOST_TEST(! context.results().has_value());
+    }
+
+    void
+    testIncremental(InfoSet const& expected)
+    {
+        BitcodeExecutionContext context(*config_, true);
+        reportUnits(context);
+        testSameInfos(expected, reduce(context));
+
+        // bitcode which cannot be decoded is
+        // reported by results, and not merged
+        BitcodeExecutionContext invalid(*config_, true);
+        std::vector<SerializedInfo> bitcode;
+        bitcode.push_back({makeID(1),
+            llvm::SmallString<0>("not bitcode")});
+        invalid.report(std::move(bitcode), Diagnostics());
+        BOOST_TEST(! invalid.results().has_value());
+    }
+
+    void
+    testSpill(InfoSet const& expected)
+    {
+        // a budget of one byte spills the
+        // bitcode after every report
+        {
+            BitcodeExecutionContext context(*config_, false, 1);
+            reportUnits(context);
+            testSameInfos(expected, reduce(context));
+        }
+
+        // a shard is written from the spill file
+        auto const path = makePath("spilled.shard");
+        {
+            BitcodeExecutionContext context(*config_, false, 1);
+            reportUnits(context);
+            if(! BOOST_TEST(context.writeShard(path).has_value()))
+                return;
+        }
+        BitcodeExecutionContext context(*config_, false, 1);
+        if(! BOOST_TEST(context.readShard(path).has_value()))
+            return;
+        testSameInfos(expected, reduce(context));
+    }
+
+    void run()
+    {
+        if(! BOOST_TEST(! llvm::sys::fs::createUniqueDirectory(
+            "mrdocs-context-test", dir_)))
+            return;
+        auto config = createConfig(
+            dir_.str(), dir_.str(), "", threadPool_);
+        if(BOOST_TEST(config.has_value()))
+        {
+            config_ = *config;
+            BitcodeExecutionContext context(*config_);
+            reportUnits(context);
+            InfoSet const expected = reduce(context);
+            testReduce(expected);
+            testShard(expected);
+            testSplitShards(expected);
+            testCorruptShard();
+            testIncremental(expected);
+            testSpill(expected);
+        }
+        llvm::sys::fs::remove_directories(dir_);
+    }
+};
+
+TEST_SUITE(
+    ExecutionContext_test,
+    "clang.mrdocs.ExecutionContext");
+
+} // mrdocs
+} // clang
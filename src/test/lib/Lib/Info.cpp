@@ -0,0 +1,131 @@
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+// Copyright (c) 2023 Vinnie Falco (vinnie.falco@gmail.com)
+//
+// Official repository: https://github.com/cppalliance/mrdocs
+//
+
+#include "lib/Lib/Info.hpp"
+#include <mrdocs/Metadata.hpp>
+#include <test_suite/test_suite.hpp>
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+namespace clang {
+namespace mrdocs {
+
+struct InfoTable_test
+{
+    static
+    SymbolID
+    makeID(std::uint32_t n)
+    {
+        std::array<std::uint8_t, 20> bytes{};
+        bytes[0] = 5;
+        for(std::size_t i = 0; i < 4; ++i)
+            bytes[i + 1] = static_cast<std::uint8_t>(n >> (8 * i));
+        return SymbolID(bytes.data());
+    }
+
+    static
+    std::unique_ptr<Info>
+    makeRecord(std::uint32_t n)
+    {
+        auto I = std::make_unique<RecordInfo>(makeID(n));
+        I->Name = "S" + std::to_string(n);
+        return I;
+    }
+
+    void
+    testEmpty()
+    {
+        InfoTable table;
+        BOOST_TEST(table.empty());
+        BOOST_TEST(table.size() == 0);
+        BOOST_TEST(table.begin() == table.end());
+        BOOST_TEST(! table.find(makeID(1)));
+        BOOST_TEST(! table.contains(SymbolID::global));
+    }
+
+    void
+    testInsert()
+    {
+        // enough symbols for the slots to grow several times
+        constexpr std::uint32_t count = 1000;
+        InfoTable table;
+        for(std::uint32_t n = 0; n < count; ++n)
+        {
+            Info* I = table.insert(makeRecord(n));
+            if(! BOOST_TEST(I))
+                return;
+            BOOST_TEST(I->id == makeID(n));
+        }
+        BOOST_TEST(table.size() == count);
+
+        for(std::uint32_t n = 0; n < count; ++n)
+        {
+            Info const* I = table.find(makeID(n));
+            if(! BOOST_TEST(I))
+                continue;
+            BOOST_TEST(I->Kind == InfoKind::Record);
+            BOOST_TEST(I->Name == "S" + std::to_string(n));
+        }
+        BOOST_TEST(! table.find(makeID(count)));
+
+        // an Info with an ID already in the table is not inserted
+        Info* first = table.find(makeID(7));
+        auto other = makeRecord(7);
+        other->Name = "other";
+        BOOST_TEST(table.insert(std::move(other)) == first);
+        BOOST_TEST(table.size() == count);
+        BOOST_TEST(first->Name == "S7");
+    }
+
+    void
+    testIteration()
+    {
+        InfoTable table;
+        InfoSet infos;
+        for(std::uint32_t n = 0; n < 100; ++n)
+            infos.emplace(makeRecord(n));
+        table.insert(std::move(infos));
+        BOOST_TEST(infos.empty());
+        BOOST_TEST(table.size() == 100);
+
+        // iteration and next visit every symbol once, in the same order
+        std::array<bool, 100> seen{};
+        Info const* expected = table.empty() ? nullptr : *table.begin();
+        for(Info const* I : table)
+        {
+            BOOST_TEST(I == expected);
+            expected = table.next(*I);
+            auto const n = std::stoul(I->Name.substr(1));
+            if(! BOOST_TEST(n < seen.size()))
+                continue;
+            BOOST_TEST(! seen[n]);
+            seen[n] = true;
+        }
+        BOOST_TEST(expected == nullptr);
+        for(bool b : seen)
+            BOOST_TEST(b);
+    }
+
+    void run()
+    {
+        testEmpty();
+        testInsert();
+        testIteration();
+    }
+};
+
+TEST_SUITE(
+    InfoTable_test,
+    "clang.mrdocs.InfoTable");
+
+} // mrdocs
+} // clang
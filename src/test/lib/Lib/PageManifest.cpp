@@ -0,0 +1,258 @@
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+// Copyright (c) 2023 Vinnie Falco (vinnie.falco@gmail.com)
+//
+// Official repository: https://github.com/cppalliance/mrdocs
+//
+
+#include "lib/AST/Bitcode.hpp"
+#include "lib/Lib/ConfigImpl.hpp"
+#include "lib/Lib/CorpusDiff.hpp"
+#include "lib/Lib/CorpusImpl.hpp"
+#include "lib/Lib/PageManifest.hpp"
+#include "lib/Support/Radix.hpp"
+#include <mrdocs/Metadata.hpp>
+#include <mrdocs/Support/ThreadPool.hpp>
+#include <test_suite/test_suite.hpp>
+#include <llvm/ADT/SmallString.h>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/Path.h>
+#include <llvm/Support/raw_ostream.h>
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+namespace clang {
+namespace mrdocs {
+
+struct PageManifest_test
+{
+    ThreadPool threadPool_;
+    llvm::SmallString<128> dir_;
+    std::shared_ptr<ConfigImpl const> config_;
+
+    static
+    SymbolID
+    makeID(std::uint32_t n)
+    {
+        std::array<std::uint8_t, 20> bytes{};
+        bytes[0] = 4;
+        for(std::size_t i = 0; i < 4; ++i)
+            bytes[i + 1] = static_cast<std::uint8_t>(n >> (8 * i));
+        return SymbolID(bytes.data());
+    }
+
+    /** Return the symbols of a small program.
+
+        namespace a { struct S; struct T; }
+
+        The name of the second record is `name`.
+    */
+    static
+    std::vector<std::unique_ptr<Info>>
+    makeSymbols(std::string_view name)
+    {
+        std::vector<std::unique_ptr<Info>> result;
+
+        auto global = std::make_unique<NamespaceInfo>(SymbolID::global);
+        global->Members.push_back(makeID(1));
+        global->Lookups["a"].push_back(makeID(1));
+
+        auto a = std::make_unique<NamespaceInfo>(makeID(1));
+        a->Name = "a";
+        a->Namespace.push_back(SymbolID::global);
+        a->Members = { makeID(2), makeID(3) };
+        a->Lookups["S"].push_back(makeID(2));
+        a->Lookups[std::string(name)].push_back(makeID(3));
+
+        auto S = std::make_unique<RecordInfo>(makeID(2));
+        S->Name = "S";
+        S->Namespace = { makeID(1), SymbolID::global };
+
+        auto T = std::make_unique<RecordInfo>(makeID(3));
+        T->Name = name;
+        T->Namespace = { makeID(1), SymbolID::global };
+
+        result.push_back(std::move(global));
+        result.push_back(std::move(a));
+        result.push_back(std::move(S));
+        result.push_back(std::move(T));
+        return result;
+    }
+
+    std::string
+    makePath(std::string_view name) const
+    {
+        llvm::SmallString<128> path(dir_);
+        llvm::sys::path::append(path, name);
+        return std::string(path.str());
+    }
+
+    bool
+    writeFile(
+        std::string const& path,
+        llvm::StringRef contents)
+    {
+        std::error_code ec;
+        llvm::raw_fd_ostream os(path, ec);
+        if(! BOOST_TEST(! ec))
+            return false;
+        os << contents;
+        return true;
+    }
+
+    /** Return a corpus of the symbols of makeSymbols.
+    */
+    std::unique_ptr<Corpus>
+    makeCorpus(std::string_view name)
+    {
+        auto const dir = makePath(name);
+        if(! BOOST_TEST(! llvm::sys::fs::create_directories(dir)))
+            return nullptr;
+        for(auto const& I : makeSymbols(name))
+        {
+            llvm::SmallString<128> path(dir);
+            llvm::sys::path::append(path, toBase16(I->id) + ".bc");
+            if(! writeFile(std::string(path.str()), writeBitcode(*I)))
+                return nullptr;
+        }
+        auto corpus = CorpusImpl::buildFromBitcode(
+            report::Level::error, config_, dir);
+        if(! BOOST_TEST(corpus.has_value()))
+            return nullptr;
+        return std::move(*corpus);
+    }
+
+    std::unique_ptr<PageManifest>
+    makeManifest(Corpus const& corpus)
+    {
+        auto hashes = hashSymbols(corpus);
+        if(! BOOST_TEST(hashes.has_value()))
+            return nullptr;
+        return std::make_unique<PageManifest>(
+            makePath("output"), makePath("templates"),
+            corpus, *std::move(hashes));
+    }
+
+    /** Render a page, recording the symbols it depends on.
+    */
+    bool
+    renderPage(
+        PageManifest& manifest,
+        std::string_view fileName,
+        std::unordered_set<SymbolID> const& ids)
+    {
+        llvm::SmallString<128> path(makePath("output"));
+        llvm::sys::path::append(path, fileName);
+        if(! writeFile(std::string(path.str()), fileName))
+            return false;
+        manifest.record(fileName, ids);
+        return true;
+    }
+
+    void
+    testSharedHashes()
+    {
+        auto corpus = makeCorpus("T");
+        if(! corpus)
+            return;
+        auto first = hashSymbols(*corpus);
+        auto second = hashSymbols(*corpus);
+        if(BOOST_TEST(first.has_value()) &&
+            BOOST_TEST(second.has_value()))
+            BOOST_TEST(first->get() == second->get());
+    }
+
+    void
+    testSkipUnchanged()
+    {
+        auto corpus = makeCorpus("T");
+        auto renamed = makeCorpus("U");
+        if(! corpus || ! renamed)
+            return;
+
+        // the first run renders every page
+        {
+            auto manifest = makeManifest(*corpus);
+            if(! manifest)
+                return;
+            BOOST_TEST(! manifest->upToDate("S.adoc"));
+            BOOST_TEST(! manifest->upToDate("T.adoc"));
+            if(! renderPage(*manifest, "S.adoc", { makeID(2) }) ||
+                ! renderPage(*manifest, "T.adoc", { makeID(3) }))
+                return;
+            manifest->save();
+        }
+
+        // the pages are up to date. a page which
+        // is not visited is kept for the next run
+        {
+            auto manifest = makeManifest(*corpus);
+            if(! manifest)
+                return;
+            BOOST_TEST(manifest->upToDate("S.adoc"));
+            manifest->save();
+        }
+        {
+            auto manifest = makeManifest(*corpus);
+            if(! manifest)
+                return;
+            BOOST_TEST(manifest->upToDate("S.adoc"));
+            BOOST_TEST(manifest->upToDate("T.adoc"));
+            manifest->save();
+        }
+
+        // only the page of the changed symbol is rendered
+        {
+            auto manifest = makeManifest(*renamed);
+            if(! manifest)
+                return;
+            BOOST_TEST(manifest->upToDate("S.adoc"));
+            BOOST_TEST(! manifest->upToDate("T.adoc"));
+            manifest->save();
+        }
+
+        // a page missing from the output is rendered
+        BOOST_TEST(! llvm::sys::fs::remove(
+            makePath("output/S.adoc")));
+        {
+            auto manifest = makeManifest(*corpus);
+            if(! manifest)
+                return;
+            BOOST_TEST(! manifest->upToDate("S.adoc"));
+        }
+    }
+
+    void run()
+    {
+        if(! BOOST_TEST(! llvm::sys::fs::createUniqueDirectory(
+            "mrdocs-manifest-test", dir_)))
+            return;
+        auto config = createConfig(
+            dir_.str(), dir_.str(), "", threadPool_);
+        if(BOOST_TEST(config.has_value()) &&
+            BOOST_TEST(! llvm::sys::fs::create_directories(
+                makePath("output"))) &&
+            BOOST_TEST(! llvm::sys::fs::create_directories(
+                makePath("templates"))))
+        {
+            config_ = *config;
+            testSharedHashes();
+            testSkipUnchanged();
+        }
+        llvm::sys::fs::remove_directories(dir_);
+    }
+};
+
+TEST_SUITE(
+    PageManifest_test,
+    "clang.mrdocs.PageManifest");
+
+} // mrdocs
+} // clang
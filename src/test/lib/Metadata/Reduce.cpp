@@ -0,0 +1,164 @@
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+// Copyright (c) 2023 Vinnie Falco (vinnie.falco@gmail.com)
+//
+// Official repository: https://github.com/cppalliance/mrdocs
+//
+
+#include "lib/Metadata/Reduce.hpp"
+#include <mrdocs/Metadata/Namespace.hpp>
+#include <test_suite/test_suite.hpp>
+#include <array>
+#include <cstdint>
+#include <unordered_set>
+
+namespace clang {
+namespace mrdocs {
+
+struct Reduce_test
+{
+    static
+    SymbolID
+    makeID(std::uint32_t n)
+    {
+        std::array<std::uint8_t, 20> bytes{};
+        bytes[0] = 1;
+        for(std::size_t i = 0; i < 4; ++i)
+            bytes[i + 1] = static_cast<std::uint8_t>(n >> (8 * i));
+        return SymbolID(bytes.data());
+    }
+
+    /** Return fragments of one namespace as reported by many TUs.
+
+        Every fragment has the shared members,
+        followed by members only it declares.
+    */
+    static
+    std::vector<std::unique_ptr<Info>>
+    makeFragments(
+        std::size_t fragments,
+        std::size_t shared,
+        std::size_t unique)
+    {
+        std::vector<std::unique_ptr<Info>> result;
+        std::uint32_t next = static_cast<std::uint32_t>(shared);
+        for(std::size_t i = 0; i < fragments; ++i)
+        {
+            auto I = std::make_unique<NamespaceInfo>(makeID(0));
+            for(std::uint32_t n = 1; n <= shared; ++n)
+            {
+                I->Members.push_back(makeID(n));
+                I->Lookups["shared"].push_back(makeID(n));
+            }
+            for(std::size_t n = 0; n < unique; ++n)
+            {
+                I->Members.push_back(makeID(++next));
+                I->Lookups["unique"].push_back(makeID(next));
+            }
+            result.push_back(std::move(I));
+        }
+        return result;
+    }
+
+    void
+    testOrder()
+    {
+        auto fragments = makeFragments(3, 4, 2);
+        auto merged = reduce<NamespaceInfo>(fragments);
+        auto const& I = static_cast<NamespaceInfo const&>(*merged);
+
+        // members keep the order in which they were first seen
+        std::vector<SymbolID> expected;
+        for(std::uint32_t n = 1; n <= 4 + 3 * 2; ++n)
+            expected.push_back(makeID(n));
+        BOOST_TEST(I.Members == expected);
+
+        BOOST_TEST(I.Lookups.size() == 2);
+        BOOST_TEST(I.Lookups.at("shared").size() == 4);
+        BOOST_TEST(I.Lookups.at("unique").size() == 3 * 2);
+    }
+
+    /** Return the members expected from merging fragments.
+    */
+    static
+    std::vector<SymbolID>
+    expectedMembers(
+        std::size_t fragments,
+        std::size_t shared,
+        std::size_t unique)
+    {
+        std::vector<SymbolID> result;
+        auto const count = static_cast<std::uint32_t>(
+            shared + fragments * unique);
+        for(std::uint32_t n = 1; n <= count; ++n)
+            result.push_back(makeID(n));
+        return result;
+    }
+
+    void
+    testLargeScope()
+    {
+        // large enough for the members to be hashed
+        std::size_t const fragments = 50;
+        std::size_t const shared = 200;
+        std::size_t const unique = 10;
+        auto values = makeFragments(fragments, shared, unique);
+
+        auto merged = reduce<NamespaceInfo>(values);
+        auto const& I = static_cast<NamespaceInfo const&>(*merged);
+
+        auto expected = expectedMembers(fragments, shared, unique);
+        BOOST_TEST(I.Members == expected);
+        BOOST_TEST(I.Lookups.size() == 2);
+        BOOST_TEST(I.Lookups.at("shared").size() == shared);
+        BOOST_TEST(I.Lookups.at("unique").size() == fragments * unique);
+        std::unordered_set<SymbolID> distinct(
+            I.Lookups.at("unique").begin(),
+            I.Lookups.at("unique").end());
+        BOOST_TEST(distinct.size() == fragments * unique);
+    }
+
+    void
+    testMergeWithSeen()
+    {
+        // merging one fragment at a time gives
+        // the same scope as reducing them all
+        std::size_t const fragments = 20;
+        std::size_t const shared = 40;
+        std::size_t const unique = 3;
+        auto values = makeFragments(fragments, shared, unique);
+
+        auto& I = static_cast<NamespaceInfo&>(*values.front());
+        ScopeMembers seen;
+        for(std::size_t i = 1; i < values.size(); ++i)
+        {
+            auto& Other = static_cast<NamespaceInfo&>(*values[i]);
+            merge(I, std::move(Other), seen);
+            BOOST_TEST(Other.Members.empty());
+            BOOST_TEST(Other.Lookups.empty());
+        }
+
+        BOOST_TEST(I.Members ==
+            expectedMembers(fragments, shared, unique));
+        BOOST_TEST(I.Lookups.at("shared").size() == shared);
+        BOOST_TEST(I.Lookups.at("unique").size() == fragments * unique);
+        BOOST_TEST(seen.members.size() == I.Members.size());
+    }
+
+    void run()
+    {
+        testOrder();
+        testLargeScope();
+        testMergeWithSeen();
+    }
+};
+
+TEST_SUITE(
+    Reduce_test,
+    "clang.mrdocs.Reduce");
+
+} // mrdocs
+} // clang
@@ -12,6 +12,7 @@
 #include "CompilerInfo.hpp"
 #include "ToolArgs.hpp"
 #include "lib/Lib/ConfigImpl.hpp"
+#include "lib/Lib/CorpusDiff.hpp"
 #include "lib/Lib/CorpusImpl.hpp"
 #include "lib/Lib/MrDocsCompilationDatabase.hpp"
 #include "llvm/Support/Program.h"
@@ -21,10 +22,93 @@
 #include <clang/Tooling/JSONCompilationDatabase.h>
 
 #include <cstdlib>
+#include <optional>
+#include <utility>
 
 namespace clang {
 namespace mrdocs {
 
+namespace {
+
+/** Parse a shard argument of the form "i/N".
+*/
+Expected<std::pair<std::size_t, std::size_t>>
+parseShard(llvm::StringRef arg)
+{
+    auto [index, count] = arg.split('/');
+    std::size_t shardIndex;
+    std::size_t shardCount;
+    if (index.getAsInteger(10, shardIndex) ||
+        count.getAsInteger(10, shardCount) ||
+        shardIndex >= shardCount)
+    {
+        return Unexpected(formatError(
+            "invalid shard \"{}\", expected i/N with 0 <= i < N",
+            arg.str()));
+    }
+    return std::make_pair(shardIndex, shardCount);
+}
+
+Expected<void>
+generateDocs(
+    Generator const& generator,
+    Corpus const& corpus,
+    std::shared_ptr<ConfigImpl const> const& config)
+{
+    // The old snapshot is loaded before the new one
+    // is written, since they can be the same file.
+    std::unique_ptr<Corpus> oldCorpus;
+    std::optional<CorpusDiff> diff;
+    if(! toolArgs.changedSince.getValue().empty())
+    {
+        MRDOCS_TRY(auto oldSnapshotPath, files::makeAbsolute(
+            files::normalizePath(toolArgs.changedSince.getValue())));
+        MRDOCS_TRY(
+            oldCorpus,
+            CorpusImpl::loadSnapshot(
+                report::Level::debug, config, oldSnapshotPath));
+        MRDOCS_TRY(diff, diffCorpora(*oldCorpus, corpus));
+        report::info(
+            "Changed since \"{}\": {} added, {} removed, {} changed, "
+            "{} pages affected", oldSnapshotPath,
+            diff->added.size(), diff->removed.size(),
+            diff->changed.size(), diff->affected.size());
+    }
+
+    if(! toolArgs.snapshotPath.getValue().empty())
+    {
+        MRDOCS_TRY(auto snapshotPath, files::makeAbsolute(
+            files::normalizePath(toolArgs.snapshotPath.getValue())));
+        report::info("Writing snapshot \"{}\"", snapshotPath);
+        MRDOCS_TRY(static_cast<CorpusImpl const&>(
+            corpus).writeSnapshot(snapshotPath));
+    }
+
+    if(corpus.empty())
+    {
+        report::warn("Corpus is empty, not generating docs");
+        return {};
+    }
+
+    // --------------------------------------------------------------
+    //
+    // Generate docs
+    //
+    // --------------------------------------------------------------
+    report::info("Generating docs\n");
+    if(diff)
+    {
+        MRDOCS_TRY(generator.buildIncremental(
+            toolArgs.outputPath.getValue(), corpus,
+            *oldCorpus, diff->affected));
+        return {};
+    }
+    MRDOCS_TRY(generator.build(toolArgs.outputPath.getValue(), corpus));
+    return {};
+}
+
+} // (anon)
+
 Expected<void>
 DoGenerateAction()
 {
@@ -41,6 +125,10 @@ DoGenerateAction()
         {
             os << "ignore-failures: true\n";
         }
+        if (toolArgs.minimalTranslationUnits.getValue())
+        {
+            os << "minimal-tu-set: true\n";
+        }
     }
 
     // Load YAML configuration file
@@ -69,6 +157,87 @@ DoGenerateAction()
             "the Generator \"{}\" was not found",
             config->settings().generate));
 
+    // Normalize outputPath path
+    MRDOCS_CHECK(toolArgs.outputPath, "The output path argument is missing");
+    toolArgs.outputPath = files::normalizePath(
+        files::makeAbsolute(toolArgs.outputPath,
+            (*config)->workingDir));
+
+    // --------------------------------------------------------------
+    //
+    // Load a snapshot
+    //
+    // --------------------------------------------------------------
+    if (toolArgs.fromSnapshot.getValue())
+    {
+        MRDOCS_CHECK(toolArgs.shard.getValue().empty() &&
+            ! toolArgs.mergeShards.getValue(),
+            "The --from-snapshot argument cannot be combined "
+            "with --shard or --merge");
+        MRDOCS_CHECK(toolArgs.inputPaths, "The snapshot path argument is missing");
+        MRDOCS_CHECK(toolArgs.inputPaths.size() == 1,
+            formatError(
+                "got {} input paths where 1 was expected",
+                toolArgs.inputPaths.size()));
+        MRDOCS_TRY(auto snapshotPath, files::makeAbsolute(
+            files::normalizePath(toolArgs.inputPaths.front())));
+        MRDOCS_TRY(
+            auto corpus,
+            CorpusImpl::loadSnapshot(
+                report::Level::info, config, snapshotPath));
+        return generateDocs(generator, *corpus, config);
+    }
+
+    // --------------------------------------------------------------
+    //
+    // Load the output of the bitcode generator
+    //
+    // --------------------------------------------------------------
+    if (toolArgs.fromBitcode.getValue())
+    {
+        MRDOCS_CHECK(toolArgs.shard.getValue().empty() &&
+            ! toolArgs.mergeShards.getValue() &&
+            ! toolArgs.fromSnapshot.getValue(),
+            "The --from-bitcode argument cannot be combined "
+            "with --shard, --merge or --from-snapshot");
+        MRDOCS_CHECK(toolArgs.inputPaths, "The bitcode path argument is missing");
+        MRDOCS_CHECK(toolArgs.inputPaths.size() == 1,
+            formatError(
+                "got {} input paths where 1 was expected",
+                toolArgs.inputPaths.size()));
+        MRDOCS_TRY(auto bitcodePath, files::makeAbsolute(
+            files::normalizePath(toolArgs.inputPaths.front())));
+        MRDOCS_TRY(
+            auto corpus,
+            CorpusImpl::buildFromBitcode(
+                report::Level::info, config, bitcodePath));
+        return generateDocs(generator, *corpus, config);
+    }
+
+    // --------------------------------------------------------------
+    //
+    // Merge shards
+    //
+    // --------------------------------------------------------------
+    if (toolArgs.mergeShards.getValue())
+    {
+        MRDOCS_CHECK(toolArgs.shard.getValue().empty(),
+            "The --shard and --merge arguments cannot be combined");
+        MRDOCS_CHECK(toolArgs.inputPaths, "The shard paths argument is missing");
+        std::vector<std::string> shardPaths;
+        for (auto const& inputPath : toolArgs.inputPaths)
+        {
+            MRDOCS_TRY(auto shardPath, files::makeAbsolute(
+                files::normalizePath(inputPath)));
+            shardPaths.push_back(std::move(shardPath));
+        }
+        MRDOCS_TRY(
+            auto corpus,
+            CorpusImpl::buildFromShards(
+                report::Level::info, config, shardPaths));
+        return generateDocs(generator, *corpus, config);
+    }
+
     // --------------------------------------------------------------
     //
     // Load the compilation database file
@@ -98,36 +267,31 @@ DoGenerateAction()
     MrDocsCompilationDatabase compilationDatabase(
             compileCommandsDir, compileCommands, config, defaultIncludePaths);
 
-    // Normalize outputPath path
-    MRDOCS_CHECK(toolArgs.outputPath, "The output path argument is missing");
-    toolArgs.outputPath = files::normalizePath(
-        files::makeAbsolute(toolArgs.outputPath,
-            (*config)->workingDir));
-
     // --------------------------------------------------------------
     //
-    // Build corpus
+    // Extract a shard
     //
     // --------------------------------------------------------------
-    MRDOCS_TRY(
-        auto corpus,
-        CorpusImpl::build(
-            report::Level::info, config, compilationDatabase));
-
-    if(corpus->empty())
+    if (! toolArgs.shard.getValue().empty())
     {
-        report::warn("Corpus is empty, not generating docs");
+        MRDOCS_TRY(auto shard, parseShard(toolArgs.shard.getValue()));
+        MRDOCS_TRY(CorpusImpl::buildShard(
+            report::Level::info, config, compilationDatabase,
+            shard.first, shard.second, toolArgs.outputPath.getValue()));
         return {};
     }
 
     // --------------------------------------------------------------
     //
-    // Generate docs
+    // Build corpus
     //
     // --------------------------------------------------------------
-    report::info("Generating docs\n");
-    MRDOCS_TRY(generator.build(toolArgs.outputPath.getValue(), *corpus));
-    return {};
+    MRDOCS_TRY(
+        auto corpus,
+        CorpusImpl::build(
+            report::Level::info, config, compilationDatabase));
+
+    return generateDocs(generator, *corpus, config);
 }
 
 } // mrdocs
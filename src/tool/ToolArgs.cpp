@@ -39,6 +39,13 @@ ADDONS:
 EXAMPLES:
     mrdocs .. ( compile-commands )
     mrdocs compile_commands.json
+    mrdocs --shard=0/2 --output=a.shard compile_commands.json
+    mrdocs --shard=1/2 --output=b.shard compile_commands.json
+    mrdocs --merge a.shard b.shard
+    mrdocs --snapshot=corpus.snapshot compile_commands.json
+    mrdocs --from-snapshot corpus.snapshot
+    mrdocs --from-bitcode bitcode-output-dir
+    mrdocs --changed-since=corpus.snapshot --snapshot=corpus.snapshot compile_commands.json
 )")
 
 //
@@ -80,6 +87,41 @@ EXAMPLES:
     llvm::cl::desc("Continue if files are not mapped correctly."),
     llvm::cl::init(true))
 
+, minimalTranslationUnits(
+    "minimal-tus",
+    llvm::cl::desc("Only extract a subset of translation units which includes every file in the source root."),
+    llvm::cl::init(false))
+
+, shard(
+    "shard",
+    llvm::cl::desc("Extract only shard i of N (written as i/N, with i starting at 0) and write it to the output path."),
+    llvm::cl::value_desc("i/N"))
+
+, mergeShards(
+    "merge",
+    llvm::cl::desc("Generate documentation from the shard files given as inputs."),
+    llvm::cl::init(false))
+
+, snapshotPath(
+    "snapshot",
+    llvm::cl::desc("Write the symbols of the corpus to a snapshot file before generating documentation."),
+    llvm::cl::value_desc("path"))
+
+, fromSnapshot(
+    "from-snapshot",
+    llvm::cl::desc("Generate documentation from the snapshot file given as input. Every symbol in the snapshot is read before generating."),
+    llvm::cl::init(false))
+
+, fromBitcode(
+    "from-bitcode",
+    llvm::cl::desc("Generate documentation from the output of the bitcode generator given as input."),
+    llvm::cl::init(false))
+
+, changedSince(
+    "changed-since",
+    llvm::cl::desc("Only generate the pages of the symbols which changed since the snapshot file was written."),
+    llvm::cl::value_desc("path"))
+
 , inputPaths(
     "inputs",
     llvm::cl::Sink,
@@ -101,6 +143,13 @@ hideForeignOptions()
         &outputPath,
         std::addressof(inputPaths),
         &ignoreMappingFailures,
+        &minimalTranslationUnits,
+        &shard,
+        &mergeShards,
+        &snapshotPath,
+        &fromSnapshot,
+        &fromBitcode,
+        &changedSince,
     });
 
     // Really hide the clang/llvm default
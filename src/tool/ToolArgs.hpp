@@ -38,6 +38,13 @@ public:
     llvm::cl::opt<std::string>  configPath;
     llvm::cl::opt<std::string>  outputPath;
     llvm::cl::opt<bool>         ignoreMappingFailures;
+    llvm::cl::opt<bool>         minimalTranslationUnits;
+    llvm::cl::opt<std::string>  shard;
+    llvm::cl::opt<bool>         mergeShards;
+    llvm::cl::opt<std::string>  snapshotPath;
+    llvm::cl::opt<bool>         fromSnapshot;
+    llvm::cl::opt<bool>         fromBitcode;
+    llvm::cl::opt<std::string>  changedSince;
     llvm::cl::list<std::string> inputPaths;
 
     // Hide all options which don't belong to us